@@ -1,8 +1,26 @@
 #include "AI.hpp"
 #include <iostream>
+#include <iomanip>
+
+constexpr int AI::MAX_DEPTH;
+std::atomic<bool> AI::stopRequested(false);
+std::atomic<uint64_t> AI::sharedNodes(0);
+std::atomic<bool> AI::pondering(false);
+std::atomic<std::chrono::steady_clock::rep> AI::clockStart(0);
+std::thread AI::searchThread;
+TranspositionTable AI::transpositionTable(16);
+int AI::threadCount = 1;
+TranspositionTable::Stats AI::lastHashStats{};
+PawnHashTable AI::pawnHashTable(1 << 16);
+PawnHashTable::Stats AI::lastPawnHashStats{};
+uint64_t AI::lastNodeCount = 0;
+AI::SearchStats AI::lastStats;
+bool AI::iterationLog = false;
+int AI::lastDepth = 0;
+int AI::lastScore = 0;
 
 // Switch statement is faster than map for short cases and we need performance here
-int AI::getPieceValue(Piece& piece) {
+int AI::getPieceValue(const Piece& piece) {
     switch (piece.getType()) {
         case Type::PAWN:   return 1;
         case Type::KNIGHT: return 3;
@@ -14,106 +32,533 @@ int AI::getPieceValue(Piece& piece) {
     }
 }
 
-// We are in a state where the move has already happened
-int AI::evaluateBoard(const Board& board, const Move& move) {
-    // Send extremely low value if white loses, or extremely high score if black loses
-    if(move == INVALID_MOVE) {
-        Team losingTeam = board.getCurrentTurn();
-        return losingTeam == Team::WHITE ?  std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+// Doubled and isolated Pawns are weak, passed Pawns grow stronger as they advance (indexed by rank from the Pawn's side)
+static constexpr int DOUBLED_PENALTY[2] = {10, 20};
+static constexpr int ISOLATED_PENALTY[2] = {10, 15};
+static constexpr int PASSED_BONUS[2][8] = {{0, 5, 10, 15, 25, 40, 60, 0}, {0, 10, 15, 25, 45, 75, 120, 0}};
+static constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+
+// Pawn-structure terms for both teams, White minus Black. Depends on the Pawns alone, so it can be cached by pawn key
+PawnHashTable::Entry AI::evaluatePawns(const Board& board) {
+    int score[2] = {0, 0}; // middlegame, endgame
+    for (int team = 0; team < 2; team++) {
+        const int sign = team == 0 ? 1 : -1;
+        const Bitboard ownPawns = board.pieces(static_cast<Team>(team), Type::PAWN);
+        const Bitboard enemyPawns = board.pieces(static_cast<Team>(1 - team), Type::PAWN);
+
+        Bitboard pawns = ownPawns;
+        while (pawns) {
+            const int square = popLsb(pawns);
+            const int file = square % 8, row = square / 8;
+            const Bitboard fileMask = FILE_A << file;
+            const Bitboard adjacentFiles = (file > 0 ? FILE_A << (file - 1) : 0) | (file < 7 ? FILE_A << (file + 1) : 0);
+
+            // White advances towards row 0, Black towards row 7
+            const Bitboard ahead = team == 0 ? (Bitboard(1) << (row * 8)) - 1 : (row < 7 ? ~((Bitboard(1) << ((row + 1) * 8)) - 1) : 0);
+            const int advanced = team == 0 ? 7 - row : row;
+
+            for (int stage = 0; stage < 2; stage++) {
+                // Every Pawn behind another on its file counts as doubled once
+                if (ownPawns & fileMask & ahead) score[stage] -= sign * DOUBLED_PENALTY[stage];
+                if (!(ownPawns & adjacentFiles)) score[stage] -= sign * ISOLATED_PENALTY[stage];
+                if (!(enemyPawns & (fileMask | adjacentFiles) & ahead)) score[stage] += sign * PASSED_BONUS[stage][advanced];
+            }
+        }
+    }
+    return PawnHashTable::Entry{static_cast<int16_t>(score[0]), static_cast<int16_t>(score[1])};
+}
+
+// Material and piece placement in centipawns from the point of view of the team about to move. The Board keeps
+// middlegame and endgame totals up to date and the pawn terms come from the pawn hash, so this only blends them
+// by how many pieces are left
+int AI::evaluateBoard(const Board& board, PawnHashTable::Stats& pawnHashStats) {
+    PawnHashTable::Entry pawns;
+    if (!pawnHashTable.probe(board.getPawnKey(), pawns, pawnHashStats)) {
+        pawns = evaluatePawns(board);
+        pawnHashTable.store(board.getPawnKey(), pawns);
+    }
+
+    int phase = std::min(board.getPhase(), PieceSquare::MAX_PHASE);
+    int middlegame = board.getMiddlegameScore() + pawns.middlegame;
+    int endgame = board.getEndgameScore() + pawns.endgame;
+    int score = (middlegame * phase + endgame * (PieceSquare::MAX_PHASE - phase)) / PieceSquare::MAX_PHASE;
+    return board.getCurrentTurn() == Team::WHITE ? score : -score;
+}
+
+int AI::evaluateBoard(const Board& board) {
+    PawnHashTable::Stats pawnHashStats{};
+    return evaluateBoard(board, pawnHashStats);
+}
+
+// Captures are ordered by MVV-LVA: the most valuable victim first, and among equal victims the cheapest attacker
+void AI::scoreMoves(const Board& board, const SearchContext& context, const MoveList& moves, int ply, Move hashMove,
+                    int* scores) {
+    const int team = static_cast<int>(board.getCurrentTurn());
+    for (size_t i = 0; i < moves.size(); i++) {
+        const int from = moves[i].from();
+        const int to = moves[i].to();
+        const Piece* attacker = board.pieceAt(board.toPosition(from));
+        const Piece* victim = board.pieceAt(board.toPosition(to));
+
+        if (moves[i] == hashMove) {
+            scores[i] = HASH_MOVE_SCORE;
+        } else if (moves[i].isPromotion() && moves[i].promotionType() != Type::QUEEN) {
+            // Underpromotions are almost never best, so they go after every quiet move
+            scores[i] = -HISTORY_LIMIT;
+        } else if (victim != EMPTY) {
+            scores[i] = CAPTURE_SCORE + getPieceValue(*victim) * 128 - getPieceValue(*attacker);
+        } else if (moves[i].isEnPassant()) {
+            scores[i] = CAPTURE_SCORE + 128 - 1;
+        } else if (ply < MAX_PLY && moves[i] == context.killers[ply][0]) {
+            scores[i] = KILLER_SCORE + 1;
+        } else if (ply < MAX_PLY && moves[i] == context.killers[ply][1]) {
+            scores[i] = KILLER_SCORE;
+        } else {
+            scores[i] = context.history[team][from][to];
+        }
+    }
+}
+
+// Moves are sorted lazily: each step only brings the best remaining move forward, so after an early cutoff
+// the rest of the list is never sorted
+void AI::pickMove(MoveList& moves, int* scores, size_t index) {
+    size_t best = index;
+    for (size_t i = index + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best]) best = i;
     }
-    Team currentTeam = board[move.endPos.rank][move.endPos.file]->getTeam();
-    int value, score = 0;
-    for(size_t i{}; i < 8; i++) {
-        for(size_t j{}; j < 8; j++) {
-            if(board[i][j] != BLANK) {
-                value = getPieceValue(*(board[i][j]));
-                score += board[i][j]->getTeam() == currentTeam ? value : (-1 * value);
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+}
+
+// Deeper cutoffs count for more. All entries are halved before they can reach the killer scores
+void AI::updateHistory(SearchContext& context, Team team, int from, int to, int depth) {
+    int& entry = context.history[static_cast<int>(team)][from][to];
+    entry += depth * depth;
+    if (entry >= HISTORY_LIMIT) {
+        for (auto& teamHistory : context.history) {
+            for (auto& fromHistory : teamHistory) {
+                for (int& value : fromHistory) value /= 2;
             }
         }
     }
-    return score;
 }
 
-// Primary Min-Max algorithm
-int AI::minMax(const std::unique_ptr<treeNode>& node, int depth, Team isMaximizingPlayer, int alpha, int beta) {
-    if (depth == 0 || node->children.empty()) {
-        return evaluateBoard(node->board, node->move);  // Leaf node: evaluate board
+// Depth-first alpha-beta in negamax form. Moves are generated at each node and discarded on return,
+// so memory grows with depth only and cut-off branches are never generated
+int AI::negaMax(Board& board, SearchContext& context, int depth, int ply, int alpha, int beta) {
+    if (depth == 0) {
+        return quiescence(board, context, ply, alpha, beta);
     }
+    context.nodes++;
+    SEARCH_STAT(context.stats.maxSelectiveDepth = std::max(context.stats.maxSelectiveDepth, ply));
+    if (shouldStop(context)) return 0; // Result is discarded by the caller
+
+    // Reuse a result for this position if it was searched at least as deep through another move order
+    const int originalAlpha = alpha;
+    const uint64_t key = board.getHashKey();
+    TranspositionTable::Entry entry;
+    Move hashMove = INVALID_MOVE;
+    if (transpositionTable.probe(key, entry, context.hashStats)) {
+        hashMove = entry.move;
+        if (entry.depth >= depth) {
+            int score = scoreFromTable(entry.score, ply);
+            if (entry.bound == TranspositionTable::Bound::EXACT ||
+               (entry.bound == TranspositionTable::Bound::LOWER && score >= beta) ||
+               (entry.bound == TranspositionTable::Bound::UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    Team team = board.getCurrentTurn();
+    MoveList moves = Check::genAllSafeMoves(board, team);
+
+    // No moves left: checkmate (sooner is worse) or stalemate
+    if (moves.empty()) {
+        Team enemyTeam = team == Team::WHITE ? Team::BLACK : Team::WHITE;
+        return checkUtils::isSquareAttacked(board, board.getKingSquare(team), enemyTeam) ? -MATE_SCORE + ply : 0;
+    }
+
+    int scores[MoveList::CAPACITY];
+    scoreMoves(board, context, moves, ply, hashMove, scores);
 
-    // Max Team is White
-    if (isMaximizingPlayer == Team::WHITE) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (const auto& child : node->children) {
-            int eval = minMax(child, depth - 1, Team::BLACK, alpha, beta);
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
-            if(beta <= alpha) break;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove = moves.front();
+    for (size_t i = 0; i < moves.size(); i++) {
+        pickMove(moves, scores, i);
+        const Move& move = moves[i];
+        bool quiet = !move.isCapture() && !move.isPromotion();
+
+        board.makeMove(move);
+        int score = -negaMax(board, context, depth - 1, ply + 1, -beta, -alpha);
+        board.unmakeMove();
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
         }
-        node->score = maxEval;
-        return maxEval;
-    } // Max Team is Black
-    else {
-        int minEval = std::numeric_limits<int>::max();
-        for (const auto& child : node->children) {
-            int eval = minMax(child, depth - 1, Team::WHITE, alpha, beta);
-            minEval = std::min(minEval, eval);
-            beta = std::min(minEval, eval);
-            if(beta <= alpha) break;
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            if (context.aborted) break;
+            SEARCH_STAT(context.stats.cutoffs++);
+            SEARCH_STAT(if (i == 0) context.stats.firstMoveCutoffs++);
+
+            // Remember quiet refutations for sibling nodes and for this move anywhere in the tree
+            if (quiet) {
+                if (ply < MAX_PLY && !(move == context.killers[ply][0])) {
+                    context.killers[ply][1] = context.killers[ply][0];
+                    context.killers[ply][0] = move;
+                }
+                updateHistory(context, team, move.from(), move.to(), depth);
+            }
+            break;
         }
-        node->score = minEval;
-        return minEval;
     }
+    if (context.aborted) return 0;
+
+    TranspositionTable::Bound bound = bestScore <= originalAlpha ? TranspositionTable::Bound::UPPER :
+                                      bestScore >= beta ? TranspositionTable::Bound::LOWER : TranspositionTable::Bound::EXACT;
+    transpositionTable.store(key, depth, bound, scoreToTable(bestScore, ply), bestMove);
+    return bestScore;
 }
 
-// Generate entire tree based on all possible moves
-void AI::generateTree(const std::unique_ptr<treeNode>& node, int depth, Team isMaximizingPlayer) {
-    if (depth == 0) return;
+// Searches only captures and promotions below the full-width depth, so no line ends in the middle of an exchange.
+// The side to move may stand pat on the static evaluation instead of capturing, unless it is in check, where every
+// evasion is searched so mates are still seen
+int AI::quiescence(Board& board, SearchContext& context, int ply, int alpha, int beta) {
+    context.nodes++;
+    SEARCH_STAT(context.stats.qnodes++);
+    SEARCH_STAT(context.stats.maxSelectiveDepth = std::max(context.stats.maxSelectiveDepth, ply));
+    if (shouldStop(context)) return 0;
+
+    Team team = board.getCurrentTurn();
+    Team enemyTeam = team == Team::WHITE ? Team::BLACK : Team::WHITE;
+    bool inCheck = checkUtils::isSquareAttacked(board, board.getKingSquare(team), enemyTeam);
+
+    int standPat = evaluateBoard(board, context.pawnHashStats);
+    SEARCH_STAT(context.stats.leafEvals++);
+    if (ply >= MAX_PLY) return standPat;
+    if (!inCheck) {
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    MoveList moves = inCheck ? Check::genAllSafeMoves(board, team) : Check::genSafeCaptures(board, team);
+    if (moves.empty()) {
+        return inCheck ? -MATE_SCORE + ply : standPat;
+    }
+
+    int scores[MoveList::CAPACITY];
+    scoreMoves(board, context, moves, ply, INVALID_MOVE, scores);
 
-    std::vector<Move> possibleMoves = Check::genAllSafeMoves(node->board, isMaximizingPlayer);
+    int bestScore = inCheck ? -INFINITE_SCORE : standPat;
+    for (size_t i = 0; i < moves.size(); i++) {
+        pickMove(moves, scores, i);
+        const Move& move = moves[i];
 
-    for (const Move& move : possibleMoves) {
-        if(move.endPos == INVALID_POS || move.startPos == INVALID_POS) continue;
-        Board newBoard = node->board;
-        checkUtils::shiftPiece(newBoard, move.startPos, move.endPos);
+        // Delta pruning: even winning the captured piece for free would leave the score below alpha
+        if (!inCheck) {
+            const Piece* victim = board.pieceAt(board.toPosition(move.to()));
+            int gain = victim != EMPTY ? getPieceValue(*victim) : 1;
+            if (move.isPromotion()) gain += 8;
+            if (standPat + gain * 100 + DELTA_MARGIN <= alpha) continue;
+        }
 
-        std::unique_ptr<treeNode> child = std::make_unique<treeNode>(newBoard, move);
-        node->children.push_back(std::move(child));
+        board.makeMove(move);
+        int score = -quiescence(board, context, ply + 1, -beta, -alpha);
+        board.unmakeMove();
+        if (context.aborted) return 0;
 
-        generateTree(node->children.back(), depth - 1, isMaximizingPlayer == Team::BLACK ? Team::WHITE : Team::BLACK);
+        bestScore = std::max(bestScore, score);
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) break;
     }
+    return bestScore;
 }
 
-Move AI::genAIMove(const Board& board, int depth, Team team) {
-    std::unique_ptr<treeNode> root = std::make_unique<treeNode>(board, Move());
-    generateTree(root, depth, team);
-
-    int bestScore = minMax(root, depth, team, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
-    std::vector<Move> bestMoves;
-    Move bestMove;
-
-    if (bestScore == std::numeric_limits<int>::max()) {
-        checkUtils::assertWinner(Team::WHITE);
-        return(Move());
-    } else if (bestScore == std::numeric_limits<int>::min()) {
-        checkUtils::assertWinner(Team::BLACK);
-        return(Move());
-    } 
-
-    for(const auto& child : root->children) {
-        if(child->score == bestScore) {
-            bestMoves.push_back(child->move);
-            break;
+// Mate scores are stored relative to the node rather than the root so they stay valid at any ply
+int AI::scoreToTable(int score, int ply) {
+    if (score >= MATE_THRESHOLD) return score + ply;
+    if (score <= -MATE_THRESHOLD) return score - ply;
+    return score;
+}
+
+int AI::scoreFromTable(int score, int ply) {
+    if (score >= MATE_THRESHOLD) return score - ply;
+    if (score <= -MATE_THRESHOLD) return score + ply;
+    return score;
+}
+
+// Polls the limits every 128 nodes so checking them costs almost nothing. Node limits apply to all threads combined.
+// Nothing is polled before the thread's first iteration completes, so there is always a searched move to return
+bool AI::shouldStop(SearchContext& context) {
+    if (context.aborted) return true;
+    if (context.completedDepth == 0 || context.nodes < context.nextCheck) return false;
+
+    context.nextCheck = context.nodes + 128;
+    if (context.limits.maxNodes) {
+        context.nextCheck = std::min(context.nextCheck, context.limits.maxNodes);
+    }
+    uint64_t totalNodes = sharedNodes.fetch_add(context.nodes - context.reportedNodes) + (context.nodes - context.reportedNodes);
+    context.reportedNodes = context.nodes;
+
+    // While pondering the clock has not started yet
+    auto elapsed = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(clockStart.load());
+    context.aborted = stopRequested.load(std::memory_order_relaxed) ||
+                      (context.limits.maxNodes && totalNodes >= context.limits.maxNodes) ||
+                      (context.limits.timeMs && !pondering.load(std::memory_order_relaxed) &&
+                       elapsed >= std::chrono::milliseconds(context.limits.timeMs));
+    return context.aborted;
+}
+
+// Search depth 1, 2, ... until a limit is hit, keeping the best move of the last iteration that finished.
+// The limits are not polled until the first iteration completes, so every thread finishes at least one
+void AI::iterativeDeepening(Board& board, MoveList moves, SearchContext& context) {
+    context.bestMove = moves.front();
+
+    // Helper threads start one ply deeper on odd ids so threads desynchronise and fill the table for each other
+    for (int depth = 1 + (context.threadId & 1); depth <= std::max(context.limits.maxDepth, 1); depth++) {
+        Move iterationBest = moves.front();
+        int alpha = -INFINITE_SCORE;
+
+        for (const Move& move : moves) {
+            board.makeMove(move);
+            int score = -negaMax(board, context, depth - 1, 1, -INFINITE_SCORE, -alpha);
+            board.unmakeMove();
+            if (context.aborted) break;
+
+            if (score > alpha) {
+                alpha = score;
+                iterationBest = move;
+            }
         }
+        if (context.aborted) break;
+
+        // Search the previous best move first in the next iteration
+        context.bestMove = iterationBest;
+        context.bestScore = alpha;
+        context.completedDepth = depth;
+        transpositionTable.store(board.getHashKey(), depth, TranspositionTable::Bound::EXACT, scoreToTable(alpha, 0),
+                                 iterationBest);
+        auto bestIt = std::find(moves.begin(), moves.end(), iterationBest);
+        std::rotate(moves.begin(), bestIt, bestIt + 1);
+
+#if CHESS_SEARCH_STATS
+        if (context.threadId == 0) {
+            auto elapsed = std::chrono::steady_clock::now() - context.startTime;
+            context.stats.iterations.push_back({depth, alpha, context.nodes,
+                                                std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()});
+            if (iterationLog) logIteration(context.stats);
+        }
+#endif
+
+        // A forced mate has been found, deeper iterations cannot improve on it
+        if (alpha >= MATE_SCORE - depth) break;
+    }
+}
+
+Move AI::genAIMove(const Board& board, const SearchLimits& limits, Team team) {
+    prepareSearch(limits);
+    return search(board, limits, team);
+}
+
+// Resets the shared flags on the caller's thread, before any search thread runs, so a stop or ponder hit
+// sent straight after starting a search is never overwritten
+void AI::prepareSearch(const SearchLimits& limits) {
+    stopRequested = false;
+    pondering = limits.ponder;
+    clockStart = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+// Lazy SMP: every thread runs its own iterative deepening on a copy of the board and they cooperate only
+// through the shared transposition table. The move of the deepest completed iteration is played
+Move AI::search(const Board& board, const SearchLimits& limits, Team team) {
+    MoveList moves = Check::genAllSafeMoves(board, team);
+    lastDepth = 0;
+    lastScore = 0;
+    lastNodeCount = 0;
+
+    // No legal moves, the caller decides how the game ends
+    if (moves.empty()) {
+        return INVALID_MOVE;
+    }
+
+    sharedNodes = 0;
+
+    std::vector<SearchContext> contexts(threadCount);
+    std::vector<Board> boards(threadCount, board);
+    for (int i = 0; i < threadCount; i++) {
+        contexts[i].limits = limits;
+        contexts[i].threadId = i;
+        contexts[i].startTime = std::chrono::steady_clock::now();
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadCount; i++) {
+        helpers.emplace_back(iterativeDeepening, std::ref(boards[i]), moves, std::ref(contexts[i]));
+    }
+    iterativeDeepening(boards[0], moves, contexts[0]);
+
+    // The main thread decides when the search is over
+    stopRequested = true;
+    for (std::thread& helper : helpers) {
+        helper.join();
     }
 
-    if(!bestMoves.empty()) {
-        bestMove = bestMoves[rand() % bestMoves.size()];
+    const SearchContext* best = &contexts[0];
+    lastHashStats = TranspositionTable::Stats{};
+    lastPawnHashStats = PawnHashTable::Stats{};
+    lastNodeCount = 0;
+    lastStats = SearchStats{};
+    lastStats.iterations = contexts[0].stats.iterations;
+    for (const SearchContext& context : contexts) {
+        lastStats.qnodes += context.stats.qnodes;
+        lastStats.leafEvals += context.stats.leafEvals;
+        lastStats.cutoffs += context.stats.cutoffs;
+        lastStats.firstMoveCutoffs += context.stats.firstMoveCutoffs;
+        lastStats.maxSelectiveDepth = std::max(lastStats.maxSelectiveDepth, context.stats.maxSelectiveDepth);
+        if (context.completedDepth > best->completedDepth) best = &context;
+        lastHashStats.hits += context.hashStats.hits;
+        lastHashStats.misses += context.hashStats.misses;
+        lastHashStats.collisions += context.hashStats.collisions;
+        lastPawnHashStats.hits += context.pawnHashStats.hits;
+        lastPawnHashStats.misses += context.pawnHashStats.misses;
+        lastNodeCount += context.nodes;
     }
+    lastStats.nodes = lastNodeCount;
+    SEARCH_STAT(lastStats.hashProbes = lastHashStats.hits + lastHashStats.misses + lastHashStats.collisions);
+    SEARCH_STAT(lastStats.hashHits = lastHashStats.hits);
+    lastDepth = best->completedDepth;
+    lastScore = best->bestScore;
+    return best->bestMove;
+}
+
+Move AI::genAIMove(const Board& board, int depth, Team team) {
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    return genAIMove(board, limits, team);
+}
+
+// Reallocating clears all stored results
+void AI::setHashSize(size_t megabytes) {
+    transpositionTable.resize(megabytes);
+}
+
+void AI::clearHash() {
+    transpositionTable.clear();
+    pawnHashTable.clear();
+}
+
+// Counters for the most recent search, summed over all threads
+const TranspositionTable::Stats& AI::getHashStats() {
+    return lastHashStats;
+}
+
+const PawnHashTable::Stats& AI::getPawnHashStats() {
+    return lastPawnHashStats;
+}
+
+uint64_t AI::getNodeCount() {
+    return lastNodeCount;
+}
 
-    return bestMove;
+// Share of beta cutoffs in the last search that came from the first move tried
+double AI::getFirstMoveCutoffRate() {
+    return lastStats.firstMoveCutoffRate();
+}
+
+const AI::SearchStats& AI::getSearchStats() {
+    return lastStats;
+}
+
+// Prints a line to standard error after every iteration of the main search thread. Does nothing without
+// CHESS_SEARCH_STATS
+void AI::setIterationLog(bool enabled) {
+    iterationLog = enabled;
+}
+
+double AI::SearchStats::firstMoveCutoffRate() const {
+    return cutoffs == 0 ? 0.0 : static_cast<double>(firstMoveCutoffs) / cutoffs;
+}
+
+// Growth in nodes from the second to last iteration to the last one, 0 before two iterations have finished
+double AI::SearchStats::branchingFactor() const {
+    if (iterations.size() < 2) return 0.0;
+    const Iteration& last = iterations.back();
+    const Iteration& previous = iterations[iterations.size() - 2];
+    uint64_t previousNodes = previous.nodes - (iterations.size() > 2 ? iterations[iterations.size() - 3].nodes : 0);
+    return previousNodes == 0 ? 0.0 : static_cast<double>(last.nodes - previous.nodes) / previousNodes;
+}
+
+void AI::logIteration(const SearchStats& stats) {
+    const SearchStats::Iteration& iteration = stats.iterations.back();
+    std::cerr << "depth " << iteration.depth << " score " << iteration.score << " nodes " << iteration.nodes
+              << " qnodes " << stats.qnodes << " seldepth " << stats.maxSelectiveDepth << " time " << iteration.timeMs
+              << " ms ebf " << std::fixed << std::setprecision(2) << stats.branchingFactor() << std::defaultfloat << std::endl;
+}
+
+// Depth and score (in centipawns, for the team that moved) of the iteration the last move came from
+int AI::getDepth() {
+    return lastDepth;
+}
+
+int AI::getScore() {
+    return lastScore;
+}
+
+void AI::setThreads(int threads) {
+    threadCount = std::max(threads, 1);
+}
+
+int AI::getThreads() {
+    return threadCount;
+}
+
+// Safe to call from another thread. The running search returns its last completed iteration
+void AI::stopSearch() {
+    stopRequested = true;
+}
+
+// Runs the search on a background thread so the caller can keep handling input, then hands the move to
+// onFinished on that thread. One search runs at a time, so this first waits for any previous one to end
+void AI::startSearch(const Board& board, const SearchLimits& limits, Team team, std::function<void(Move)> onFinished) {
+    waitForSearch();
+    prepareSearch(limits);
+    searchThread = std::thread([board, limits, team, onFinished]() {
+        onFinished(search(board, limits, team));
+    });
+}
+
+// Must not be called from onFinished, which runs on the search thread itself
+void AI::waitForSearch() {
+    if (searchThread.joinable()) {
+        searchThread.join();
+    }
+}
+
+// The predicted move was played: a pondering search becomes a normal one and its time limit starts now
+void AI::ponderHit() {
+    clockStart = std::chrono::steady_clock::now().time_since_epoch().count();
+    pondering = false;
+}
+
+// The stored best move for the position, if the table still holds one and it is legal there.
+// After a search this gives the expected reply to the chosen move
+Move AI::getHashMove(const Board& board) {
+    TranspositionTable::Entry entry;
+    TranspositionTable::Stats stats{};
+    if (!transpositionTable.probe(board.getHashKey(), entry, stats) || entry.move == INVALID_MOVE) {
+        return INVALID_MOVE;
+    }
+    for (const Move& move : Check::genAllSafeMoves(board, board.getCurrentTurn())) {
+        if (move == entry.move) {
+            return move;
+        }
+    }
+    return INVALID_MOVE;
 }
 
-Move AI::genRandomMove(const Board& board, Team team) {
-    std::vector<Move> moves = Check::genAllSafeMoves(board, team);
-    return moves.at(rand() % moves.size());
+Move AI::genRandomMove(Board& board, Team team) {
+    MoveList moves = Check::genAllSafeMoves(board, team);
+    return moves[rand() % moves.size()];
 }
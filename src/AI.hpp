@@ -1,30 +1,155 @@
 #pragma once
 
 #include "Board.hpp"
-#include "Game.hpp"
 #include "Check.hpp"
 #include "CheckUtils.hpp"
+#include "TranspositionTable.hpp"
+#include "PieceSquare.hpp"
+#include "PawnHashTable.hpp"
 #include <vector>
-#include <memory>
 #include <algorithm>
 #include <limits>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <functional>
+
+// Search statistics cost a few counters per node. Building with CHESS_SEARCH_STATS=0 compiles them out
+#ifndef CHESS_SEARCH_STATS
+#define CHESS_SEARCH_STATS 1
+#endif
+#if CHESS_SEARCH_STATS
+#define SEARCH_STAT(statement) statement
+#else
+#define SEARCH_STAT(statement)
+#endif
 
 class AI {
+    public:
+    // Deepest iteration a search may be asked for. Extensions and quiescence go further, up to MAX_PLY
+    static constexpr int MAX_DEPTH = 64;
+
+    // Bounds on a single search. Zero means no limit for time and nodes
+    struct SearchLimits {
+        int timeMs = 0;
+        int maxDepth = MAX_DEPTH;
+        uint64_t maxNodes = 0;
+        bool ponder = false; // The time limit only starts counting once ponderHit is called
+    };
+
+    // Counters for one search, summed over all threads. The iterations are those of the main thread.
+    // Everything except nodes stays zero when CHESS_SEARCH_STATS is off
+    struct SearchStats {
+        struct Iteration {
+            int depth;
+            int score;
+            uint64_t nodes; // Searched by the main thread up to the end of this iteration
+            int64_t timeMs;
+        };
+
+        uint64_t nodes = 0;
+        uint64_t qnodes = 0; // Part of nodes spent in the quiescence search
+        uint64_t leafEvals = 0;
+        uint64_t hashProbes = 0;
+        uint64_t hashHits = 0;
+        uint64_t cutoffs = 0;
+        uint64_t firstMoveCutoffs = 0; // Cutoffs caused by the first move searched, a measure of ordering quality
+        int maxSelectiveDepth = 0; // Deepest ply reached, quiescence included
+        std::vector<Iteration> iterations;
+
+        double firstMoveCutoffRate() const;
+        double branchingFactor() const;
+    };
+
+    static constexpr int MATE_SCORE = 100000;
+    static constexpr int MATE_THRESHOLD = MATE_SCORE - 1000; // Scores beyond this are mates in some number of plies
+
     private:
-    struct treeNode {
-        Board board;
-        Move move;
-        int score;
-        std::vector<std::unique_ptr<treeNode>> children;
-        treeNode(Board newBoard, Move newMove) : board(newBoard),  move (newMove), score(0) {}
+    static constexpr int INFINITE_SCORE = 1000000;
+    static constexpr int MAX_PLY = 128;
+
+    // Ordering scores: hash move, then captures, then the two killers, then quiet moves by history
+    static constexpr int HASH_MOVE_SCORE = 1 << 30;
+    static constexpr int CAPTURE_SCORE = 1 << 28;
+    static constexpr int KILLER_SCORE = 1 << 27;
+    static constexpr int HISTORY_LIMIT = 1 << 20; // History is halved once an entry reaches this
+
+    // Quiescence skips captures that cannot lift the score to alpha even with this much to spare, in centipawns
+    static constexpr int DELTA_MARGIN = 200;
+
+    // State owned by one search thread. Threads only share the transposition table and the stop flag
+    struct SearchContext {
+        SearchLimits limits;
+        int threadId = 0;
+        uint64_t nodes = 0;
+        uint64_t nextCheck = 0;
+        uint64_t reportedNodes = 0;
+        bool aborted = false;
+        int completedDepth = 0;
+        int bestScore = 0;
+        Move bestMove = INVALID_MOVE;
+        TranspositionTable::Stats hashStats{};
+        PawnHashTable::Stats pawnHashStats{};
+        SearchStats stats;
+        std::chrono::steady_clock::time_point startTime;
+        Move killers[MAX_PLY][2] = {}; // Quiet moves that caused a cutoff at each ply
+        int history[2][64][64] = {}; // Per team and from/to square, raised by quiet moves that caused a cutoff
     };
+    static std::atomic<bool> stopRequested;
+    static std::atomic<uint64_t> sharedNodes;
+    static std::atomic<bool> pondering;
+    static std::atomic<std::chrono::steady_clock::rep> clockStart; // When the time limit started counting
+    static std::thread searchThread;
+    static TranspositionTable transpositionTable;
+    static int threadCount;
+    static TranspositionTable::Stats lastHashStats;
+    static PawnHashTable pawnHashTable;
+    static PawnHashTable::Stats lastPawnHashStats;
+    static uint64_t lastNodeCount;
+    static SearchStats lastStats;
+    static bool iterationLog;
+    static int lastDepth;
+    static int lastScore;
 
-    static int evaluateBoard(const Board& board, const Move& move);
-    static int minMax(const std::unique_ptr<treeNode>& node, int depth, Team isMaximizingPlayer, int alpha, int beta);
-    static int getPieceValue(Piece& piece);
-    static void generateTree(const std::unique_ptr<treeNode>& node, int depth, Team isMaximizingPlayer);
+    static int evaluateBoard(const Board& board, PawnHashTable::Stats& pawnHashStats);
+    static PawnHashTable::Entry evaluatePawns(const Board& board);
+    static int negaMax(Board& board, SearchContext& context, int depth, int ply, int alpha, int beta);
+    static int quiescence(Board& board, SearchContext& context, int ply, int alpha, int beta);
+    static int getPieceValue(const Piece& piece);
+    static void scoreMoves(const Board& board, const SearchContext& context, const MoveList& moves, int ply, Move hashMove,
+                           int* scores);
+    static void pickMove(MoveList& moves, int* scores, size_t index);
+    static void updateHistory(SearchContext& context, Team team, int from, int to, int depth);
+    static bool shouldStop(SearchContext& context);
+    static void logIteration(const SearchStats& stats);
+    static void iterativeDeepening(Board& board, MoveList moves, SearchContext& context);
+    static int scoreToTable(int score, int ply);
+    static int scoreFromTable(int score, int ply);
+    static void prepareSearch(const SearchLimits& limits);
+    static Move search(const Board& board, const SearchLimits& limits, Team team);
 
     public:
+    static Move genAIMove(const Board& board, const SearchLimits& limits, Team team);
+    static int evaluateBoard(const Board& board);
     static Move genAIMove(const Board& board, int depth, Team team);
-    static Move genRandomMove(const Board& board, Team team);
+    static Move genRandomMove(Board& board, Team team);
+    static void stopSearch();
+    static void startSearch(const Board& board, const SearchLimits& limits, Team team, std::function<void(Move)> onFinished);
+    static void waitForSearch();
+    static void ponderHit();
+    static Move getHashMove(const Board& board);
+    static void setHashSize(size_t megabytes);
+    static void clearHash();
+    static const TranspositionTable::Stats& getHashStats();
+    static const PawnHashTable::Stats& getPawnHashStats();
+    static void setThreads(int threads);
+    static int getThreads();
+    static uint64_t getNodeCount();
+    static double getFirstMoveCutoffRate();
+    static const SearchStats& getSearchStats();
+    static void setIterationLog(bool enabled);
+    static int getDepth();
+    static int getScore();
 };
@@ -0,0 +1,182 @@
+#include "Attacks.hpp"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+// Found offline for this square layout (a8 = 0) with a sparse random search
+static constexpr Bitboard rookMagicNumbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+static constexpr Bitboard bishopMagicNumbers[64] = {
+    0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+    0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+    0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+    0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+    0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
+
+static Bitboard rookTable[102400];
+static Bitboard bishopTable[5248];
+
+Attacks::Magic Attacks::rookMagics[64];
+Attacks::Magic Attacks::bishopMagics[64];
+bool Attacks::usePext = false;
+Bitboard Attacks::betweenTable[64][64];
+Bitboard Attacks::lineTable[64][64];
+
+static constexpr bool onBoard(int rank, int file) {
+    return rank >= 0 && rank < 8 && file >= 0 && file < 8;
+}
+
+static constexpr Bitboard leaperAttacks(int square, const int (*offsets)[2], int count) {
+    Bitboard attacks = 0;
+    for(int i = 0; i < count; i++) {
+        int rank = square / 8 + offsets[i][0];
+        int file = square % 8 + offsets[i][1];
+        if(onBoard(rank, file)) attacks |= Bitboard(1) << (rank * 8 + file);
+    }
+    return attacks;
+}
+
+static constexpr Attacks::LeaperTables generateLeapers() {
+    constexpr int knightOffsets[8][2] = {{2, 1}, {1, 2}, {2, -1}, {1, -2}, {-2, 1}, {-1, 2}, {-2, -1}, {-1, -2}};
+    constexpr int kingOffsets[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    constexpr int whitePawnOffsets[2][2] = {{-1, -1}, {-1, 1}}; // White moves towards rank index 0
+    constexpr int blackPawnOffsets[2][2] = {{1, -1}, {1, 1}};
+
+    Attacks::LeaperTables tables{};
+    for(int square = 0; square < 64; square++) {
+        tables.knight[square] = leaperAttacks(square, knightOffsets, 8);
+        tables.king[square] = leaperAttacks(square, kingOffsets, 8);
+        tables.pawn[0][square] = leaperAttacks(square, whitePawnOffsets, 2);
+        tables.pawn[1][square] = leaperAttacks(square, blackPawnOffsets, 2);
+    }
+    return tables;
+}
+
+constexpr Attacks::LeaperTables Attacks::leapers = generateLeapers();
+
+// Walks each ray until the edge or a blocker (blocker included). Only used to fill the tables
+static Bitboard slowSlidingAttacks(int square, Bitboard occupied, const int (*directions)[2]) {
+    Bitboard attacks = 0;
+    for(int i = 0; i < 4; i++) {
+        int rank = square / 8 + directions[i][0];
+        int file = square % 8 + directions[i][1];
+        while(onBoard(rank, file)) {
+            Bitboard bit = Bitboard(1) << (rank * 8 + file);
+            attacks |= bit;
+            if(occupied & bit) break;
+            rank += directions[i][0];
+            file += directions[i][1];
+        }
+    }
+    return attacks;
+}
+
+// Blocker mask: the rays without their last square, since a piece on the edge never blocks anything further
+static Bitboard relevantMask(int square, const int (*directions)[2]) {
+    Bitboard mask = 0;
+    for(int i = 0; i < 4; i++) {
+        int rank = square / 8 + directions[i][0];
+        int file = square % 8 + directions[i][1];
+        while(onBoard(rank + directions[i][0], file + directions[i][1])) {
+            mask |= Bitboard(1) << (rank * 8 + file);
+            rank += directions[i][0];
+            file += directions[i][1];
+        }
+    }
+    return mask;
+}
+
+// Enumerates every subset of each mask (Carry-Rippler) and stores its attack set at the computed index
+static void buildTable(Attacks::Magic* magics, const Bitboard* magicNumbers, Bitboard* table, const int (*directions)[2]) {
+    Bitboard* next = table;
+    for(int square = 0; square < 64; square++) {
+        Attacks::Magic& entry = magics[square];
+        entry.mask = relevantMask(square, directions);
+        entry.magic = magicNumbers[square];
+        entry.shift = 64 - popCount(entry.mask);
+        entry.attacks = next;
+
+        Bitboard subset = 0;
+        do {
+            next[Attacks::slidingIndex(entry, subset)] = slowSlidingAttacks(square, subset, directions);
+            subset = (subset - entry.mask) & entry.mask;
+        } while(subset);
+        next += Bitboard(1) << popCount(entry.mask);
+    }
+}
+
+// Uses the finished sliding tables: two aligned squares see each other on an empty board
+static void buildLineTables() {
+    for(int from = 0; from < 64; from++) {
+        for(int to = 0; to < 64; to++) {
+            Bitboard toBit = Bitboard(1) << to;
+            Bitboard fromBit = Bitboard(1) << from;
+            if(Attacks::rookAttacks(from, 0) & toBit) {
+                Attacks::betweenTable[from][to] = Attacks::rookAttacks(from, toBit) & Attacks::rookAttacks(to, fromBit);
+                Attacks::lineTable[from][to] = (Attacks::rookAttacks(from, 0) & Attacks::rookAttacks(to, 0)) | fromBit | toBit;
+            } else if(Attacks::bishopAttacks(from, 0) & toBit) {
+                Attacks::betweenTable[from][to] = Attacks::bishopAttacks(from, toBit) & Attacks::bishopAttacks(to, fromBit);
+                Attacks::lineTable[from][to] = (Attacks::bishopAttacks(from, 0) & Attacks::bishopAttacks(to, 0)) | fromBit | toBit;
+            }
+        }
+    }
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+// PEXT is microcoded and slow on AMD before Zen 3, where magics win. Zen 3 and later are family 0x19 and up
+static bool hasFastPext() {
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("bmi2")) return false;
+    if(!__builtin_cpu_is("amd")) return true;
+
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    unsigned int family = (eax >> 8) & 0xF;
+    if(family == 0xF) family += (eax >> 20) & 0xFF;
+    return family >= 0x19;
+}
+#endif
+
+// Runs during static initialization, before main
+static bool initializeSlidingTables() {
+#if defined(__GNUC__) && defined(__x86_64__)
+    Attacks::usePext = hasFastPext();
+#endif
+    constexpr int rookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    constexpr int bishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    buildTable(Attacks::rookMagics, rookMagicNumbers, rookTable, rookDirections);
+    buildTable(Attacks::bishopMagics, bishopMagicNumbers, bishopTable, bishopDirections);
+    buildLineTables();
+    return true;
+}
+
+static const bool slidingTablesReady = initializeSlidingTables();
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Board.hpp"
+
+// Precomputed attack sets. Sliding pieces use magic bitboards: the relevant blockers are multiplied by a
+// per-square magic and shifted down to index a table of every possible attack set. On BMI2 hosts the
+// index is taken with PEXT instead, chosen once at startup
+namespace Attacks {
+    struct Magic {
+        Bitboard mask; // Squares whose occupancy affects the attack set, edges excluded
+        Bitboard magic;
+        const Bitboard* attacks;
+        unsigned shift;
+    };
+
+    struct LeaperTables {
+        Bitboard knight[64];
+        Bitboard king[64];
+        Bitboard pawn[2][64]; // Capture squares, indexed by team
+    };
+
+    extern Magic rookMagics[64];
+    extern Magic bishopMagics[64];
+    extern bool usePext;
+    extern const LeaperTables leapers;
+    extern Bitboard betweenTable[64][64];
+    extern Bitboard lineTable[64][64];
+
+    inline unsigned slidingIndex(const Magic& entry, Bitboard occupied) {
+#if defined(__GNUC__) && defined(__x86_64__)
+        // Inline assembly keeps PEXT out of the compiler's instruction selection, so the binary still runs without BMI2
+        if(usePext) {
+            Bitboard index;
+            __asm__("pextq %2, %1, %0" : "=r"(index) : "r"(occupied), "r"(entry.mask));
+            return static_cast<unsigned>(index);
+        }
+#endif
+        return static_cast<unsigned>(((occupied & entry.mask) * entry.magic) >> entry.shift);
+    }
+
+    inline Bitboard rookAttacks(int square, Bitboard occupied) {
+        return rookMagics[square].attacks[slidingIndex(rookMagics[square], occupied)];
+    }
+    inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+        return bishopMagics[square].attacks[slidingIndex(bishopMagics[square], occupied)];
+    }
+    inline Bitboard queenAttacks(int square, Bitboard occupied) {
+        return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+    }
+    inline Bitboard knightAttacks(int square) {return leapers.knight[square];}
+    inline Bitboard kingAttacks(int square) {return leapers.king[square];}
+    inline Bitboard pawnAttacks(Team team, int square) {return leapers.pawn[static_cast<int>(team)][square];}
+
+    // Squares strictly between two squares sharing a rank, file or diagonal. Empty if they are not aligned
+    inline Bitboard between(int from, int to) {return betweenTable[from][to];}
+    // The full edge-to-edge line through both squares. Empty if they are not aligned
+    inline Bitboard line(int from, int to) {return lineTable[from][to];}
+};
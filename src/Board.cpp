@@ -1,103 +1,389 @@
 #include "Board.hpp"
 #include "Check.hpp"
 #include "CheckUtils.hpp"
+#include "Zobrist.hpp"
+#include "PieceSquare.hpp"
 #include <iostream>
 #include <string>
+#include <cstring>
 #include <algorithm>
-#include <vector>
+#include <type_traits>
 #include <cassert>
+#include <cstdlib>
+
+// Copies must stay a flat memcpy so the search can duplicate boards without touching the heap
+static_assert(std::is_trivially_copyable<Board>::value, "Board must be trivially copyable");
+
+constexpr uint8_t Board::NO_PIECE;
+constexpr uint8_t Board::NO_SQUARE;
+constexpr int Board::MAX_HISTORY;
+
+const Piece Board::pieceTable[2][6] = {
+    {Piece(Type::KING, Team::WHITE), Piece(Type::QUEEN, Team::WHITE), Piece(Type::ROOK, Team::WHITE),
+     Piece(Type::KNIGHT, Team::WHITE), Piece(Type::BISHOP, Team::WHITE), Piece(Type::PAWN, Team::WHITE)},
+    {Piece(Type::KING, Team::BLACK), Piece(Type::QUEEN, Team::BLACK), Piece(Type::ROOK, Team::BLACK),
+     Piece(Type::KNIGHT, Team::BLACK), Piece(Type::BISHOP, Team::BLACK), Piece(Type::PAWN, Team::BLACK)}};
+
+// Rights lost when a piece moves from or to each square (King and Rook home squares)
+static uint8_t castlingMask(int square) {
+    switch(square) {
+        case 0:  return Board::BLACK_QUEENSIDE;
+        case 4:  return Board::BLACK_KINGSIDE | Board::BLACK_QUEENSIDE;
+        case 7:  return Board::BLACK_KINGSIDE;
+        case 56: return Board::WHITE_QUEENSIDE;
+        case 60: return Board::WHITE_KINGSIDE | Board::WHITE_QUEENSIDE;
+        case 63: return Board::WHITE_KINGSIDE;
+        default: return 0;
+    }
+}
 
 // Initialize all the pieces of the board
-Board::Board(Team team) : currentTeamTurn(Team::WHITE) {
-    initializeMap();
+Board::Board(Team team) : currentTeamTurn(Team::WHITE), castlingCheck(0xF), enPassantSquare(NO_SQUARE),
+                          halfmoveClock(0), fullmoveNumber(1), hashKey(Zobrist::keys.castling[0xF]), pawnKey(0),
+                          middlegameScore(0), endgameScore(0), phase(0),
+                          pieceBB{}, teamBB{}, occupiedBB(0), kingSquare{}, historyCount(0) {
+    std::fill(mailbox, mailbox + 64, NO_PIECE);
 
     constexpr Type pieceLayout[] = {Type::ROOK, Type::KNIGHT, Type::BISHOP, Type::QUEEN,
                                     Type::KING, Type::BISHOP, Type::KNIGHT, Type::ROOK};
-    for(size_t i{}; i < 8; i++) {
+    for(int i{}; i < 8; i++) {
         // Pawns
-        grid[1][i] = std::make_unique<Piece>(Type::PAWN, Team::BLACK);
-        grid[6][i] = std::make_unique<Piece>(Type::PAWN, Team::WHITE);
+        placePiece(8 + i, Team::BLACK, Type::PAWN);
+        placePiece(48 + i, Team::WHITE, Type::PAWN);
         // Other pieces
-        grid[0][i] = std::make_unique<Piece>(pieceLayout[i], Team::BLACK);
-        grid[7][i] = std::make_unique<Piece>(pieceLayout[i], Team::WHITE);
+        placePiece(i, Team::BLACK, pieceLayout[i]);
+        placePiece(56 + i, Team::WHITE, pieceLayout[i]);
     }
 }
 
-bool Board::movePiece(Position startPos, Position endPos) {
-    // Flip all positions if its Black
-    if(currentTeamTurn == Team::BLACK) {
-        startPos.rank = 7 - startPos.rank;
-        startPos.file = 7 - startPos.file;
-        endPos.rank = 7 - endPos.rank;
-        endPos.file = 7 - endPos.file;
+// Piece letters in mailbox order, White's first: index team * 6 + type
+static const char pieceSymbols[] = "KQRNBPkqrnbp";
+
+// Reads the unsigned number a FEN field starts with and moves the cursor past it
+static bool parseNumber(const char*& cursor, uint16_t& value) {
+    if(*cursor < '0' || *cursor > '9') return false;
+    uint32_t number = 0;
+    while(*cursor >= '0' && *cursor <= '9') {
+        number = number * 10 + (*cursor++ - '0');
+        if(number > 0xFFFF) return false;
     }
+    value = static_cast<uint16_t>(number);
+    return true;
+}
 
-    Piece* piece = grid[startPos.rank][startPos.file].get();
-    if(piece == EMPTY || piece->getTeam() != currentTeamTurn || !Check::canMoveToSpot(*this, startPos, endPos)) return false;
-    
-    // Perform castling move and return early
-    if(checkUtils::isCastlingMove(*this, startPos, endPos)) {
-        return checkUtils::canCastle(*this, startPos, endPos) ? (checkUtils::performCastle(*this, startPos, endPos), true) : false;
+// Sets up the position described by a FEN string: placement, side to move, castling rights, en passant square and
+// the two move clocks. Everything after the side to move may be left out. The string is read in place, nothing is
+// allocated. Castling rights without their King and Rook at home are dropped. Returns false and leaves the board
+// untouched if the string is malformed or the position cannot arise in a game: a King missing, the side not to
+// move in check, a Pawn on the first or last rank, or an en passant square that cannot follow a double step
+bool Board::loadFen(const char* fen) {
+    Board position(Team::WHITE);
+    for(Bitboard occupied = position.occupancy(); occupied;) position.clearSquare(popLsb(occupied));
+
+    const char* cursor = fen;
+    auto atFieldEnd = [&cursor]() {return *cursor == ' ' || *cursor == '\0';};
+    auto nextField = [&cursor]() {
+        while(*cursor == ' ') cursor++;
+        return *cursor != '\0';
+    };
+
+    // Ranks are listed from 8 down to 1, which matches the square order a8 = 0 ... h1 = 63
+    if(!nextField()) return false;
+    int square = 0;
+    for(; !atFieldEnd(); cursor++) {
+        char symbol = *cursor;
+        if(symbol == '/') {
+            if(square % 8 != 0) return false;
+        } else if(symbol >= '1' && symbol <= '8') {
+            square += symbol - '0';
+        } else {
+            const char* found = std::strchr(pieceSymbols, symbol);
+            if(found == nullptr || *found == '\0' || square >= 64) return false;
+            int piece = static_cast<int>(found - pieceSymbols);
+            // A Pawn can never stand on the first or last rank
+            if(piece % 6 == static_cast<int>(Type::PAWN) && (square < 8 || square >= 56)) return false;
+            position.placePiece(square++, static_cast<Team>(piece / 6), static_cast<Type>(piece % 6));
+        }
     }
+    if(square != 64 || popCount(position.pieces(Team::WHITE, Type::KING)) != 1 ||
+       popCount(position.pieces(Team::BLACK, Type::KING)) != 1) return false;
 
-    // Mark if rook or king moves to prevent double castling
-    if(piece->getType() == Type::KING || piece->getType() == Type::ROOK) {
-       checkUtils::castlingMark(*this, startPos);
+    if(!nextField() || (*cursor != 'w' && *cursor != 'b')) return false;
+    position.currentTeamTurn = *cursor++ == 'w' ? Team::WHITE : Team::BLACK;
+    if(!atFieldEnd()) return false;
+
+    // The side that just moved cannot have left its King in check, or the King itself could be captured
+    Team waitingTeam = position.currentTeamTurn == Team::WHITE ? Team::BLACK : Team::WHITE;
+    if(checkUtils::isSquareAttacked(position, position.getKingSquare(waitingTeam), position.currentTeamTurn)) return false;
+
+    position.castlingCheck = 0;
+    if(nextField()) {
+        for(; !atFieldEnd(); cursor++) {
+            switch(*cursor) {
+                case 'K': position.castlingCheck |= WHITE_KINGSIDE; break;
+                case 'Q': position.castlingCheck |= WHITE_QUEENSIDE; break;
+                case 'k': position.castlingCheck |= BLACK_KINGSIDE; break;
+                case 'q': position.castlingCheck |= BLACK_QUEENSIDE; break;
+                case '-': break;
+                default: return false;
+            }
+        }
     }
 
-    // Perform Move
-    checkUtils::shiftPiece(*this, startPos, endPos);
+    // A right only stays if its King and Rook are still on their home squares
+    struct CastlingHome {
+        uint8_t right;
+        Team team;
+        int kingSquare, rookSquare;
+    };
+    static const CastlingHome castlingHomes[] = {
+        {WHITE_KINGSIDE, Team::WHITE, 60, 63}, {WHITE_QUEENSIDE, Team::WHITE, 60, 56},
+        {BLACK_KINGSIDE, Team::BLACK, 4, 7}, {BLACK_QUEENSIDE, Team::BLACK, 4, 0}};
+    for(const CastlingHome& home : castlingHomes) {
+        if(!(position.pieces(home.team, Type::KING) & (Bitboard(1) << home.kingSquare)) ||
+           !(position.pieces(home.team, Type::ROOK) & (Bitboard(1) << home.rookSquare))) {
+            position.castlingCheck &= ~home.right;
+        }
+    }
+
+    position.enPassantSquare = NO_SQUARE;
+    if(nextField()) {
+        if(*cursor == '-') {
+            cursor++;
+        } else {
+            if(cursor[0] < 'a' || cursor[0] > 'h' || cursor[1] < '1' || cursor[1] > '8') return false;
+            int target = ('8' - cursor[1]) * 8 + (cursor[0] - 'a');
 
-    // Promote all pawns if there are any
-    checkUtils::pawnPromotion(*this);
+            // The target lies behind an enemy Pawn that just made its double step: on rank 6 with White to move,
+            // on rank 3 with Black to move. The square it skipped and the one it started from are both empty
+            int forward = position.currentTeamTurn == Team::WHITE ? 8 : -8;
+            int pawnSquare = target + forward;
+            bool onTargetRank = position.currentTeamTurn == Team::WHITE ? cursor[1] == '6' : cursor[1] == '3';
+            Bitboard passedSquares = (Bitboard(1) << target) | (Bitboard(1) << (target - forward));
+            if(!onTargetRank || !(position.pieces(waitingTeam, Type::PAWN) & (Bitboard(1) << pawnSquare)) ||
+               (position.occupancy() & passedSquares)) return false;
+            position.enPassantSquare = static_cast<uint8_t>(target);
+            cursor += 2;
+        }
+        if(!atFieldEnd()) return false;
+    }
 
+    position.halfmoveClock = 0;
+    position.fullmoveNumber = 1;
+    if(nextField() && (!parseNumber(cursor, position.halfmoveClock) || !atFieldEnd())) return false;
+    if(nextField() && (!parseNumber(cursor, position.fullmoveNumber) || !atFieldEnd() || position.fullmoveNumber == 0)) {
+        return false;
+    }
+    if(nextField()) return false;
+
+    position.historyCount = 0;
+    position.hashKey = position.computeHashKey();
+    *this = position;
     return true;
 }
 
-void Board::rotateBoard() {
-    for(size_t i{}; i < 4; i++) 
-        for (size_t j{}; j < 8; j++) {
-            std::swap(grid[i][j], grid[7 - i][j]);
-        }
+// The position as a FEN string, the inverse of loadFen
+std::string Board::toFen() const {
+    std::string fen;
+    fen.reserve(96);
 
-    for(size_t i{}; i < 8; i++) 
-        for (size_t j{}; j < 4; j++) {
-            std::swap(grid[i][j], grid[i][7 - j]);
+    for(int square = 0; square < 64; square++) {
+        if(mailbox[square] == NO_PIECE) {
+            // Runs of empty squares are counted, so a digit is extended rather than appended
+            if(!fen.empty() && fen.back() >= '1' && fen.back() <= '7') fen.back()++;
+            else fen += '1';
+        } else {
+            fen += pieceSymbols[mailbox[square]];
         }
+        if(square % 8 == 7 && square != 63) fen += '/';
+    }
+
+    fen += currentTeamTurn == Team::WHITE ? " w " : " b ";
+    if(castlingCheck & WHITE_KINGSIDE) fen += 'K';
+    if(castlingCheck & WHITE_QUEENSIDE) fen += 'Q';
+    if(castlingCheck & BLACK_KINGSIDE) fen += 'k';
+    if(castlingCheck & BLACK_QUEENSIDE) fen += 'q';
+    if(castlingCheck == 0) fen += '-';
+
+    fen += ' ';
+    if(enPassantSquare == NO_SQUARE) {
+        fen += '-';
+    } else {
+        fen += static_cast<char>('a' + enPassantSquare % 8);
+        fen += static_cast<char>('8' - enPassantSquare / 8);
+    }
+
+    fen += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+    return fen;
 }
 
-void Board::changeTurns() {
-    currentTeamTurn = currentTeamTurn == Team::WHITE ? Team::BLACK : Team::WHITE;
+// Plays a move entered in the GUI if it is legal. Only this one move is checked, by the moving piece's own rules and
+// then for King safety, so no full move list is generated. The board has no piece picker, so a promotion is to a Queen
+bool Board::movePiece(Position startPos, Position endPos) {
+    const Piece* piece = pieceAt(startPos);
+    if(piece == EMPTY || piece->getTeam() != currentTeamTurn || !Check::canMoveToSpot(*this, startPos, endPos)) return false;
+
+    // Castling is entered by selecting the Rook and then the King, and is played as the King's two-square move
+    if(checkUtils::isCastlingMove(*this, startPos, endPos)) {
+        Position kingPos = endPos;
+        endPos = Position(kingPos.rank, kingPos.file + (startPos.file > kingPos.file ? 2 : -2));
+        startPos = kingPos;
+    }
+
+    playMove(Move(toSquare(startPos), toSquare(endPos)));
+    return true;
 }
 
-Board::Board(const Board& board) : currentTeamTurn(board.getCurrentTurn()), castlingCheck(board.castlingCheck) {
-    for(size_t i{}; i < 8; i++) {
-        for(size_t j{}; j < 8; j++) {
-            if (board.grid[i][j] != EMPTY) {
-                (this->grid)[i][j] = std::make_unique<Piece>(*board.grid[i][j]);
-            } else {
-                (this->grid)[i][j] = EMPTY;
-            }
-        }
+// Plays a move without validating it and records how to take it back. Used by the search and legality checks
+void Board::makeMove(Move move) {
+    assert(historyCount < MAX_HISTORY);
+    int from = move.from();
+    int to = move.to();
+    uint8_t piece = mailbox[from];
+    Team team = static_cast<Team>(piece / 6);
+    Type type = static_cast<Type>(piece % 6);
+
+    UndoRecord& undo = history[historyCount++];
+    undo.from = static_cast<uint8_t>(from);
+    undo.to = static_cast<uint8_t>(to);
+    undo.captured = mailbox[to];
+    undo.castlingRights = castlingCheck;
+    undo.enPassantSquare = enPassantSquare;
+    undo.flags = 0;
+    undo.halfmoveClock = halfmoveClock;
+
+    if(type == Type::PAWN && to == enPassantSquare) {
+        // The captured Pawn stands behind the square it skipped
+        int capturedSquare = to + (team == Team::WHITE ? 8 : -8);
+        undo.captured = mailbox[capturedSquare];
+        undo.flags |= UndoRecord::EN_PASSANT;
+        clearSquare(capturedSquare);
+    } else if(type == Type::KING && std::abs(to - from) == 2) {
+        // Castling is the King's two-square move, the Rook lands on the square the King crossed
+        undo.flags |= UndoRecord::CASTLING;
+        relocatePiece(to > from ? from + 3 : from - 4, (from + to) / 2);
     }
+
+    relocatePiece(from, to);
+
+    // Pawns reaching the last rank are promoted to the piece the move names, a Queen if it names none
+    if(type == Type::PAWN && (to < 8 || to >= 56)) {
+        undo.flags |= UndoRecord::PROMOTION;
+        placePiece(to, team, move.isPromotion() ? move.promotionType() : Type::QUEEN);
+    }
+
+    setEnPassantSquare(type == Type::PAWN && std::abs(to - from) == 16 ? (from + to) / 2 : NO_SQUARE);
+    clearCastlingRights(from);
+    clearCastlingRights(to);
+
+    // Captures and Pawn moves restart the count toward the fifty-move rule
+    halfmoveClock = type == Type::PAWN || undo.captured != NO_PIECE ? 0 : halfmoveClock + 1;
+    if(team == Team::BLACK) fullmoveNumber++;
+    changeTurns();
+}
+
+void Board::unmakeMove() {
+    assert(historyCount > 0);
+    const UndoRecord& undo = history[--historyCount];
+    uint8_t piece = mailbox[undo.to];
+    Team team = static_cast<Team>(piece / 6);
+
+    clearSquare(undo.to);
+    placePiece(undo.from, team, (undo.flags & UndoRecord::PROMOTION) ? Type::PAWN : static_cast<Type>(piece % 6));
+    if(undo.captured != NO_PIECE) {
+        int capturedSquare = (undo.flags & UndoRecord::EN_PASSANT) ? undo.to + (team == Team::WHITE ? 8 : -8) : undo.to;
+        placePiece(capturedSquare, static_cast<Team>(undo.captured / 6), static_cast<Type>(undo.captured % 6));
+    }
+    if(undo.flags & UndoRecord::CASTLING) {
+        relocatePiece((undo.from + undo.to) / 2, undo.to > undo.from ? undo.from + 3 : undo.from - 4);
+    }
+
+    hashKey ^= Zobrist::keys.castling[castlingCheck] ^ Zobrist::keys.castling[undo.castlingRights];
+    castlingCheck = undo.castlingRights;
+    setEnPassantSquare(undo.enPassantSquare);
+    halfmoveClock = undo.halfmoveClock;
+    if(team == Team::BLACK) fullmoveNumber--;
+    changeTurns();
+}
+
+// Plays a move for the rest of the game. Its undo record is dropped, so game length is not bounded by the history
+void Board::playMove(Move move) {
+    makeMove(move);
+    historyCount--;
+}
+
+void Board::changeTurns() {
+    currentTeamTurn = currentTeamTurn == Team::WHITE ? Team::BLACK : Team::WHITE;
+    hashKey ^= Zobrist::keys.blackToMove;
 }
 
 Team Board::getCurrentTurn() const {
     return currentTeamTurn;
 }
 
-void Board::initializeMap() {
-    castlingMap["whiteLeftRook"] = &castlingCheck.whiteLeftRook;
-    castlingMap["whiteRightRook"] = &castlingCheck.whiteRightRook;
-    castlingMap["whiteKing"] = &castlingCheck.whiteKing;
-    castlingMap["blackLeftRook"] = &castlingCheck.blackLeftRook;
-    castlingMap["blackRightRook"] = &castlingCheck.blackRightRook;
-    castlingMap["blackKing"] = &castlingCheck.blackKing;
+void Board::placePiece(int square, Team team, Type type) {
+    clearSquare(square);
+
+    Bitboard mask = Bitboard(1) << square;
+    pieceBB[static_cast<int>(team)][static_cast<int>(type)] |= mask;
+    teamBB[static_cast<int>(team)] |= mask;
+    occupiedBB |= mask;
+    mailbox[square] = static_cast<uint8_t>(static_cast<int>(team) * 6 + static_cast<int>(type));
+    if(type == Type::KING) kingSquare[static_cast<int>(team)] = static_cast<uint8_t>(square);
+    hashKey ^= Zobrist::keys.pieces[mailbox[square]][square];
+    if(type == Type::PAWN) pawnKey ^= Zobrist::keys.pieces[mailbox[square]][square];
+    middlegameScore += PieceSquare::tables.middlegame[mailbox[square]][square];
+    endgameScore += PieceSquare::tables.endgame[mailbox[square]][square];
+    phase += PieceSquare::phaseWeights[static_cast<int>(type)];
+}
+
+void Board::clearSquare(int square) {
+    uint8_t piece = mailbox[square];
+    if(piece == NO_PIECE) return;
+
+    Bitboard mask = Bitboard(1) << square;
+    pieceBB[piece / 6][piece % 6] &= ~mask;
+    teamBB[piece / 6] &= ~mask;
+    occupiedBB &= ~mask;
+    mailbox[square] = NO_PIECE;
+    hashKey ^= Zobrist::keys.pieces[piece][square];
+    if(piece % 6 == static_cast<int>(Type::PAWN)) pawnKey ^= Zobrist::keys.pieces[piece][square];
+    middlegameScore -= PieceSquare::tables.middlegame[piece][square];
+    endgameScore -= PieceSquare::tables.endgame[piece][square];
+    phase -= PieceSquare::phaseWeights[piece % 6];
+}
+
+// Moves whatever stands on from to to, capturing anything already there
+void Board::relocatePiece(int from, int to) {
+    uint8_t piece = mailbox[from];
+    assert(piece != NO_PIECE);
+    clearSquare(from);
+    placePiece(to, static_cast<Team>(piece / 6), static_cast<Type>(piece % 6));
+}
+
+uint8_t Board::getCastlingRights() const {
+    return castlingCheck;
+}
+
+void Board::clearCastlingRights(int square) {
+    hashKey ^= Zobrist::keys.castling[castlingCheck];
+    castlingCheck &= ~castlingMask(square);
+    hashKey ^= Zobrist::keys.castling[castlingCheck];
+}
+
+void Board::setEnPassantSquare(int square) {
+    if(enPassantSquare != NO_SQUARE) hashKey ^= Zobrist::keys.enPassant[enPassantSquare % 8];
+    enPassantSquare = static_cast<uint8_t>(square);
+    if(enPassantSquare != NO_SQUARE) hashKey ^= Zobrist::keys.enPassant[enPassantSquare % 8];
 }
 
-void Board::setMoved(const std::string& piece) {
-    auto it = castlingMap.find(piece);
-    if(it != castlingMap.end()) {
-        *(it->second) = true;
+// Full recomputation of the incremental key, for verifying it
+uint64_t Board::computeHashKey() const {
+    uint64_t key = Zobrist::keys.castling[castlingCheck];
+    if(currentTeamTurn == Team::BLACK) key ^= Zobrist::keys.blackToMove;
+    if(enPassantSquare != NO_SQUARE) key ^= Zobrist::keys.enPassant[enPassantSquare % 8];
+    for(int square = 0; square < 64; square++) {
+        if(mailbox[square] != NO_PIECE) key ^= Zobrist::keys.pieces[mailbox[square]][square];
     }
+    return key;
 }
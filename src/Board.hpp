@@ -1,41 +1,129 @@
 #pragma once
 
 #include "Piece.hpp"
-#include <memory>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 
+using Bitboard = uint64_t;
+
+// Bit helpers for iterating over bitboards
+inline int lsb(Bitboard bitboard) {return __builtin_ctzll(bitboard);}
+inline int popCount(Bitboard bitboard) {return __builtin_popcountll(bitboard);}
+inline int popLsb(Bitboard& bitboard) {
+    int square = lsb(bitboard);
+    bitboard &= bitboard - 1;
+    return square;
+}
+
+// Squares are indexed 0-63 in absolute coordinates: a8 = 0, h8 = 7, ..., a1 = 56, h1 = 63.
+// Positions use the same fixed grid, rank 0 being the eighth rank. Which side is drawn at the bottom is up to the GUI
 class Board {
     private:
     Team currentTeamTurn;
 
-    struct castlingBool {
-        bool whiteLeftRook, whiteRightRook, whiteKing,
-             blackLeftRook, blackRightRook, blackKing;
-        castlingBool() 
-        : whiteLeftRook(false), whiteRightRook(false), whiteKing(false),
-          blackLeftRook(false), blackRightRook(false), blackKing(false) {}
-    } castlingCheck;
+    // Castling rights, cleared whenever a King or Rook leaves (or a Rook is captured on) its home square
+    uint8_t castlingCheck;
+
+    // Square skipped by a Pawn's double step on the last move, NO_SQUARE otherwise
+    uint8_t enPassantSquare;
+
+    // Moves since the last capture or Pawn move, and the number of the current full move as FEN counts them
+    uint16_t halfmoveClock;
+    uint16_t fullmoveNumber;
+
+    // Zobrist key of the position, updated incrementally by every change below
+    uint64_t hashKey;
+    uint64_t pawnKey; // The same keys for the Pawns alone, for caching pawn-structure scores
+
+    // Material plus piece-square totals (White minus Black) and the game phase, updated the same way
+    int middlegameScore;
+    int endgameScore;
+    int phase;
+
+    // One mask per team and piece type, plus occupancy masks and a square lookup for O(1) piece queries
+    Bitboard pieceBB[2][6];
+    Bitboard teamBB[2];
+    Bitboard occupiedBB;
+    uint8_t mailbox[64];
+    uint8_t kingSquare[2]; // Cached so finding a King never needs a scan
+
+    // Compact record of everything makeMove overwrites, so unmakeMove can restore it exactly
+    struct UndoRecord {
+        enum Flags : uint8_t {PROMOTION = 1, CASTLING = 2, EN_PASSANT = 4};
+        uint8_t from, to;
+        uint8_t captured; // NO_PIECE for quiet moves
+        uint8_t castlingRights;
+        uint8_t enPassantSquare;
+        uint8_t flags;
+        uint16_t halfmoveClock;
+    };
+    static constexpr int MAX_HISTORY = 256;
+    UndoRecord history[MAX_HISTORY];
+    int historyCount;
+
+    static const Piece pieceTable[2][6];
 
-    void initializeMap();
+    const Piece* pieceOnGrid(int square) const {
+        uint8_t piece = mailbox[square];
+        return piece == NO_PIECE ? EMPTY : &pieceTable[piece / 6][piece % 6];
+    }
+
+    void setEnPassantSquare(int square);
 
     struct Row {
-        std::unique_ptr<Piece>* row;
-        Piece* operator[](int col) {return row[col].get();} // uses array notation on row pointer to retreive specific element
-        Piece* operator[](int col) const {return row[col].get();}
+        const Board* board;
+        int row;
+        const Piece* operator[](int col) const {return board->pieceOnGrid(row * 8 + col);}
     };
 
     public:
-    std::unordered_map<std::string, bool*> castlingMap;
-    std::unique_ptr<Piece> grid[8][8];
-    Row operator[](int row) {return Row{grid[row]};} // initializes row in Row class to grid[row], which is a piece* (recall grid is a piece**)
-    const Row operator[](int row) const {return Row{const_cast<std::unique_ptr<Piece>*>(grid[row])};}
+    static constexpr uint8_t NO_PIECE = 12;
+    static constexpr uint8_t NO_SQUARE = 64;
+
+    enum CastlingRights : uint8_t {
+        WHITE_KINGSIDE = 1, WHITE_QUEENSIDE = 2, BLACK_KINGSIDE = 4, BLACK_QUEENSIDE = 8
+    };
+
+    Row operator[](int row) const {return Row{this, row};} // view used by the GUI: board[rank][file] returns the Piece or EMPTY
 
     Board(Team team);
-    Board(const Board& board);
-    void setMoved(const std::string& piece);
-    void rotateBoard();
+    bool loadFen(const char* fen);
+    bool loadFen(const std::string& fen) {return loadFen(fen.c_str());}
+    std::string toFen() const;
     bool movePiece(Position start, Position end);
+    void makeMove(Move move);
+    void unmakeMove();
+    void playMove(Move move);
     void changeTurns();
     Team getCurrentTurn() const;
+
+    // Coordinate conversion between the Position grid and absolute squares
+    static int toSquare(Position pos) {return pos.rank * 8 + pos.file;}
+    static Position toPosition(int square) {return Position(square / 8, square % 8);}
+
+    // Bitboard queries
+    const Piece* pieceAt(Position pos) const {return pieceOnGrid(pos.rank * 8 + pos.file);}
+    uint8_t pieceOn(int square) const {return mailbox[square];}
+    Bitboard pieces(Team team, Type type) const {return pieceBB[static_cast<int>(team)][static_cast<int>(type)];}
+    Bitboard teamPieces(Team team) const {return teamBB[static_cast<int>(team)];}
+    Bitboard occupancy() const {return occupiedBB;}
+    int getKingSquare(Team team) const {return kingSquare[static_cast<int>(team)];}
+
+    // Raw square manipulation. Does not validate the move or switch turns
+    void placePiece(int square, Team team, Type type);
+    void clearSquare(int square);
+    void relocatePiece(int from, int to);
+
+    uint8_t getCastlingRights() const;
+    void clearCastlingRights(int square);
+    int getEnPassantSquare() const {return enPassantSquare;}
+    int getHalfmoveClock() const {return halfmoveClock;}
+    int getFullmoveNumber() const {return fullmoveNumber;}
+
+    uint64_t getHashKey() const {return hashKey;}
+    uint64_t getPawnKey() const {return pawnKey;}
+    int getMiddlegameScore() const {return middlegameScore;}
+    int getEndgameScore() const {return endgameScore;}
+    int getPhase() const {return phase;}
+    uint64_t computeHashKey() const;
 };
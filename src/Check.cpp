@@ -1,17 +1,13 @@
 #include "Check.hpp"
 #include "CheckUtils.hpp"
+#include "Attacks.hpp"
 #include <iostream>
-#include <functional>
 
 // Determines whether a piece can move to a certain position. Performs theoretical move to ensure no check.
-bool Check::canMoveToSpot(const Board& board, Position startPos, Position endPos) {
+bool Check::canMoveToSpot(Board& board, Position startPos, Position endPos) {
     using namespace checkUtils;
 
-    bool isValidMove = false;
-    auto it = canMoveFunctions.find(board[startPos.rank][startPos.file]->getType());
-    if(it != canMoveFunctions.end()) {
-        isValidMove = it->second(board, startPos, endPos);
-    }
+    bool isValidMove = canMove(board, startPos, endPos);
 
     // If its a valid move and we perform the move, will the King be in check
     if(isValidMove && (isCastlingMove(board, startPos, endPos) || isKingSafe(board, startPos, endPos))) {
@@ -20,63 +16,162 @@ bool Check::canMoveToSpot(const Board& board, Position startPos, Position endPos
     return false;
 }
 
-// Determines if either team has been checkmated
-bool Check::isCheckMate(const Board& board) {
-    using namespace checkUtils;
+static void addMoves(const Board& board, int from, Bitboard targets, MoveList& moves) {
+    Bitboard occupied = board.occupancy();
+    while(targets) {
+        int to = popLsb(targets);
+        moves.push_back(Move(from, to, (occupied >> to) & 1 ? Move::CAPTURE : 0));
+    }
+}
 
-    Team teams[] = {Team::WHITE, Team::BLACK};
-    for(Team team : teams) {
-        bool isCheckMate = true;
-        Position kingPos = locateKing(board, team);
-        if(!isKingInCheck(board, kingPos, team)) continue;
-
-        // If any move results in King being safe, its not a checkmate
-        std::vector<Move> moves = genAllMoves(board, team);
-        for(auto move : moves) {
-            if(isKingSafe(board, move.startPos, move.endPos)) {
-                isCheckMate = false;
-                break;
-            }
+// A Pawn reaching the last rank may become any of these. The captures-only generator keeps just the Queen
+static constexpr Type promotionTypes[] = {Type::QUEEN, Type::KNIGHT, Type::ROOK, Type::BISHOP};
+
+static void addPawnMoves(const Board& board, int from, Bitboard targets, bool queenOnly, MoveList& moves) {
+    Bitboard occupied = board.occupancy();
+    while(targets) {
+        int to = popLsb(targets);
+        bool capture = (occupied >> to) & 1;
+        if(to >= 8 && to < 56) {
+            moves.push_back(Move(from, to, capture ? Move::CAPTURE : 0));
+            continue;
         }
-        
-        if(isCheckMate) {
-            return true;
+        for(Type type : promotionTypes) {
+            moves.push_back(Move::promotion(from, to, type, capture));
+            if(queenOnly) break;
         }
     }
-    return false;
 }
 
-// Generates all moves for a specific team. Does not check for King safety
-std::vector<Move> Check::genAllMoves(const Board& board, Team team) {
+// King and Rook squares for each castling move, indexed by team then side
+struct CastlingPath {
+    uint8_t right;
+    int kingFrom, kingTo, rookFrom;
+};
+static const CastlingPath castlingPaths[2][2] = {
+    {{Board::WHITE_KINGSIDE, 60, 62, 63}, {Board::WHITE_QUEENSIDE, 60, 58, 56}},
+    {{Board::BLACK_KINGSIDE, 4, 6, 7}, {Board::BLACK_QUEENSIDE, 4, 2, 0}}};
+
+// Generates only legal moves. Checking pieces and pinned pieces are found once up front from the King's square,
+// so no move has to be played and taken back to prove it is safe.
+// With capturesOnly every target is masked down to enemy pieces, except Pawn pushes onto the last rank, so the
+// quiet moves are never built
+static MoveList genLegalMoves(const Board& board, Team team, bool capturesOnly) {
     using namespace checkUtils;
 
-    std::vector<Move> moves;
-    std::unordered_map<Type, genMoveFunction>::iterator it;
+    MoveList moves;
 
-    for(size_t i{}; i < 8; i++) {
-        for(size_t j{}; j < 8; j++) {
-            if(board[j][i] == EMPTY || board[j][i]->getTeam() != team) continue;
+    Team enemyTeam = team == Team::WHITE ? Team::BLACK : Team::WHITE;
+    int kingSquare = board.getKingSquare(team);
+    Bitboard kingBit = Bitboard(1) << kingSquare;
+    Bitboard occupied = board.occupancy();
+    Bitboard ownPieces = board.teamPieces(team);
+    Bitboard checkers = attackersTo(board, kingSquare, enemyTeam, occupied);
+    Bitboard enemyPieces = board.teamPieces(enemyTeam);
+    Bitboard moveMask = capturesOnly ? enemyPieces : ~Bitboard(0);
+
+    // The King is tested with itself lifted off the board, so it cannot hide behind its own square from a slider
+    Bitboard kingTargets = Attacks::kingAttacks(kingSquare) & ~ownPieces & moveMask;
+    while(kingTargets) {
+        int to = popLsb(kingTargets);
+        if(!attackersTo(board, to, enemyTeam, occupied ^ kingBit)) addMoves(board, kingSquare, Bitboard(1) << to, moves);
+    }
+
+    // In double check only the King can move
+    if(popCount(checkers) > 1) return moves;
+
+    // Out of check, other pieces must capture the checker or block between it and the King
+    Bitboard targetMask = checkers ? checkers | Attacks::between(kingSquare, lsb(checkers)) : ~ownPieces;
+
+    // A lone piece of ours between the King and an enemy slider on the same line is pinned to that line
+    Bitboard pinned = 0;
+    Bitboard enemyQueens = board.pieces(enemyTeam, Type::QUEEN);
+    Bitboard snipers = (Attacks::rookAttacks(kingSquare, 0) & (board.pieces(enemyTeam, Type::ROOK) | enemyQueens)) |
+                       (Attacks::bishopAttacks(kingSquare, 0) & (board.pieces(enemyTeam, Type::BISHOP) | enemyQueens));
+    while(snipers) {
+        Bitboard blockers = Attacks::between(kingSquare, popLsb(snipers)) & occupied;
+        if(popCount(blockers) == 1) pinned |= blockers & ownPieces;
+    }
+    auto allowedTargets = [&](int from) {
+        return (pinned >> from) & 1 ? targetMask & Attacks::line(kingSquare, from) : targetMask;
+    };
+
+    // A pinned Knight can never stay on the line, so it has no moves at all
+    Bitboard knights = board.pieces(team, Type::KNIGHT) & ~pinned;
+    while(knights) {
+        int from = popLsb(knights);
+        addMoves(board, from, Attacks::knightAttacks(from) & targetMask & moveMask, moves);
+    }
 
-            it = genMoveFunctions.find(board.grid[j][i].get()->getType());
-            if(it != genMoveFunctions.end()) {
-                it->second(board, Position(j, i), moves);
+    Bitboard queens = board.pieces(team, Type::QUEEN);
+    Bitboard diagonalSliders = board.pieces(team, Type::BISHOP) | queens;
+    while(diagonalSliders) {
+        int from = popLsb(diagonalSliders);
+        addMoves(board, from, Attacks::bishopAttacks(from, occupied) & allowedTargets(from) & moveMask, moves);
+    }
+    Bitboard straightSliders = board.pieces(team, Type::ROOK) | queens;
+    while(straightSliders) {
+        int from = popLsb(straightSliders);
+        addMoves(board, from, Attacks::rookAttacks(from, occupied) & allowedTargets(from) & moveMask, moves);
+    }
+
+    // White always advances towards square 0 and Black towards square 63
+    int forward = team == Team::WHITE ? -8 : 8;
+    Bitboard promotionRank = team == Team::WHITE ? 0xFFULL : 0xFFULL << 56;
+    Bitboard pawnMask = capturesOnly ? enemyPieces | promotionRank : ~Bitboard(0);
+    Bitboard pawns = board.pieces(team, Type::PAWN);
+    while(pawns) {
+        int from = popLsb(pawns);
+        Bitboard targets = Attacks::pawnAttacks(team, from) & enemyPieces;
+
+        Bitboard singleStep = Bitboard(1) << (from + forward);
+        if(!(occupied & singleStep)) {
+            targets |= singleStep;
+            bool onStartingRank = team == Team::WHITE ? from >= 48 : from < 16;
+            if(onStartingRank) {
+                Bitboard doubleStep = Bitboard(1) << (from + 2 * forward);
+                if(!(occupied & doubleStep)) targets |= doubleStep;
             }
         }
+        addPawnMoves(board, from, targets & pawnMask & allowedTargets(from), capturesOnly, moves);
     }
-    return moves;
-}
 
-// Generates all safe moves. Slower than normal gen all moves
-std::vector<Move> Check::genAllSafeMoves(const Board& board, Team team) {
-    std::vector<Move> moves = Check::genAllMoves(board, team);
+    // En passant takes two pieces off the board at once, which can uncover the King along a rank.
+    // It is rare enough to simply look at the King's attackers in the resulting occupancy
+    int enPassantSquare = board.getEnPassantSquare();
+    if(enPassantSquare != Board::NO_SQUARE && team == board.getCurrentTurn()) {
+        Bitboard capturedBit = Bitboard(1) << (enPassantSquare - forward);
+        Bitboard capturers = Attacks::pawnAttacks(enemyTeam, enPassantSquare) & board.pieces(team, Type::PAWN);
+        while(capturers) {
+            int from = popLsb(capturers);
+            Bitboard after = (occupied ^ (Bitboard(1) << from) ^ capturedBit) | (Bitboard(1) << enPassantSquare);
+            if(!(attackersTo(board, kingSquare, enemyTeam, after) & ~capturedBit)) {
+                moves.push_back(Move(from, enPassantSquare, Move::CAPTURE | Move::EN_PASSANT));
+            }
+        }
+    }
+
+    // Castling needs the right, empty squares between King and Rook, and a King that is not in, passing through or
+    // landing in check
+    if(!checkers && !capturesOnly) {
+        for(const CastlingPath& path : castlingPaths[static_cast<int>(team)]) {
+            if(!(board.getCastlingRights() & path.right) || kingSquare != path.kingFrom ||
+               !(board.pieces(team, Type::ROOK) & (Bitboard(1) << path.rookFrom)) ||
+               (Attacks::between(path.kingFrom, path.rookFrom) & occupied)) continue;
 
-    auto it = moves.begin();
-    while(it != moves.end()) {
-        if(!Check::canMoveToSpot(board, it->startPos, it->endPos)) {
-            it = moves.erase(it);
-        } else {
-            ++it;
+            int crossedSquare = (path.kingFrom + path.kingTo) / 2;
+            if(isSquareAttacked(board, crossedSquare, enemyTeam) || isSquareAttacked(board, path.kingTo, enemyTeam)) continue;
+            moves.push_back(Move(path.kingFrom, path.kingTo, Move::CASTLING));
         }
     }
     return moves;
-}
\ No newline at end of file
+}
+
+MoveList Check::genAllSafeMoves(const Board& board, Team team) {
+    return genLegalMoves(board, team, false);
+}
+
+// Legal captures, en passant and promotions only, for the quiescence search
+MoveList Check::genSafeCaptures(const Board& board, Team team) {
+    return genLegalMoves(board, team, true);
+}
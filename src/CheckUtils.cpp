@@ -1,6 +1,37 @@
 #include "CheckUtils.hpp"
+#include "Attacks.hpp"
+
+// Pushes and captures of the Pawn on the square, en passant included. Squares are absolute, so White always advances
+// towards square 0 and Black towards square 63, whichever side the board is drawn from
+static Bitboard pawnTargets(const Board& board, int square) {
+    Team team = static_cast<Team>(board.pieceOn(square) / 6);
+    Team enemyTeam = team == Team::WHITE ? Team::BLACK : Team::WHITE;
+    Bitboard empty = ~board.occupancy();
+
+    Bitboard targets = Attacks::pawnAttacks(team, square) & board.teamPieces(enemyTeam);
+
+    int forward = team == Team::WHITE ? -8 : 8;
+    Bitboard singleStep = Bitboard(1) << (square + forward);
+    if(empty & singleStep) {
+        targets |= singleStep;
+        bool onStartingRank = team == Team::WHITE ? square >= 48 : square < 16;
+        Bitboard doubleStep = Bitboard(1) << (square + 2 * forward);
+        if(onStartingRank && (empty & doubleStep)) targets |= doubleStep;
+    }
+
+    int enPassantSquare = board.getEnPassantSquare();
+    if(enPassantSquare != Board::NO_SQUARE && team == board.getCurrentTurn()) {
+        targets |= Attacks::pawnAttacks(team, square) & (Bitboard(1) << enPassantSquare);
+    }
+    return targets;
+}
 
 bool checkUtils::canMoveKing(const Board& board, Position startPos, Position endPos) {
+    // The two-square move along the home rank castles with the Rook in that corner
+    if(startPos.rank == endPos.rank && abs(endPos.file - startPos.file) == 2) {
+        return canCastle(board, Position(startPos.rank, endPos.file > startPos.file ? 7 : 0), startPos);
+    }
+
     Team kingTeam = board[startPos.rank][startPos.file]->getTeam();
     // Check if King falls into check at end position
     if(checkBounds(board, startPos, endPos) && !isKingInCheck(board, endPos, kingTeam) && isOneTile(startPos, endPos)) {
@@ -37,53 +68,26 @@ bool checkUtils::canMoveBishop(const Board& board, Position startPos, Position e
 bool checkUtils::canMoveKnight(const Board& board, Position startPos, Position endPos) {
     if(!checkBounds(board, startPos, endPos)) return false;
     // Check to see if the end position is any 8 of the possible knights' spots
-    for(size_t i{}; i < 8; i++) {
-        if(startPos.rank + knightOffsets[i].rank == endPos.rank && startPos.file + knightOffsets[i].file == endPos.file) {
-            return true;
-        }
-    }
-    return false;
+    return Attacks::knightAttacks(board.toSquare(startPos)) & (Bitboard(1) << board.toSquare(endPos));
 }
 
 
 bool checkUtils::canMovePawn(const Board& board, Position startPos, Position endPos) {
     if(!checkBounds(board, startPos, endPos)) return false;
-
-    Piece* startPosPiece = board[startPos.rank][startPos.file];
-    Piece* endPosPiece = board[endPos.rank][endPos.file];
-
-    Team startTeam = startPosPiece->getTeam();
-    int rankMoveDirection = (board.getCurrentTurn() == Team::WHITE) 
-                ? (startTeam == Team::WHITE ? -1 : 1)
-                : (startTeam == Team::WHITE ? 1 : -1);
-
-
-    bool isSameFile = (endPos.file == startPos.file);
-    bool isEndPositionEmpty = (endPosPiece == EMPTY);
-    bool isJumpTileEmpty = (board[startPos.rank + (1 * rankMoveDirection)][startPos.file] == EMPTY);
-    bool isSingleStepMove = (endPos.rank == startPos.rank - 1);
-    bool isDoubleStepMove = (endPos.rank == startPos.rank - 2 && startPos.rank == 6);
-    bool isDiagonalMove = (isSingleStepMove && (abs(endPos.file - startPos.file) == 1));
-    bool isCaptureMove = (!isEndPositionEmpty && endPosPiece->getTeam() != startPosPiece->getTeam());
-    bool forwardMove = isSameFile && isEndPositionEmpty && (isSingleStepMove || (isDoubleStepMove && isJumpTileEmpty));
-    bool captureMove = isDiagonalMove && isCaptureMove;
-
-    if(forwardMove || captureMove) {
-        return true;
-    }
-    return false;
+    return pawnTargets(board, board.toSquare(startPos)) & (Bitboard(1) << board.toSquare(endPos));
 }
 
 // Returns true if Positions are within the board and not moving to spot taken by teammate
 bool checkUtils::checkBounds(const Board& board, Position startPos, Position endPos) {
-    Piece* endPosPiece = board[endPos.rank][endPos.file];
-    Piece* startPosPiece = board[startPos.rank][startPos.file];
-
     // Out of bounds
     if (endPos.file > 7 || endPos.file < 0 || endPos.rank > 7 || endPos.rank < 0 ) {
         return false;
-    } // Moving to spot where its not null and spot occupied by teammate
-    else if (endPosPiece != EMPTY && endPosPiece->getTeam() == startPosPiece->getTeam()) {
+    }
+
+    const Piece* endPosPiece = board[endPos.rank][endPos.file];
+    const Piece* startPosPiece = board[startPos.rank][startPos.file];
+    // Moving to spot where its not null and spot occupied by teammate
+    if (endPosPiece != EMPTY && endPosPiece->getTeam() == startPosPiece->getTeam()) {
         return false;
     } // Else within Bounds
     else return true;
@@ -99,37 +103,16 @@ bool checkUtils::checkDiags(Position startPos, Position endPos) {
     return (abs(endPos.rank - startPos.rank) == abs(startPos.file - endPos.file));
 }
 
+// Returns true if the piece can slide to endPos along one of its lines without being blocked or landing on a teammate
 bool checkUtils::checkSliding(const Board& board, Position startPos, Position endPos, slideType type) {
-    // Obtain direction vector (Ex. gives (1,0) if going from (3,4) to (7,4))
-    int rankDirection = (endPos.rank > startPos.rank) - (endPos.rank < startPos.rank);
-    int fileDirection = (endPos.file > startPos.file) - (endPos.file < startPos.file);
-
-    // Determine range of indexing arrays based on piece type
-    int start = type == slideType::Bishop ? 4 : 0;
-    int end = type == slideType::Rook ? 4 : 8;
-
-    for(int i = start; i < end; i++) {
-        if(rankDirection == slidingOffsets[i].rank && fileDirection == slidingOffsets[i].file) {
-            Team startPosTeam = board[startPos.rank][startPos.file]->getTeam();
-            Team enemyTeam = startPosTeam == Team::WHITE ? Team::BLACK : Team::WHITE;
-
-            // Step incrementally from startPos to endPos and see if any obstructions
-            do {
-                startPos.rank += rankDirection;
-                startPos.file += fileDirection;
-
-                Piece* currentPiece = board[startPos.rank][startPos.file];
-                // Check Obstruction: If space is not null and occupied by teammate OR occupied by enemy BUT is not the final position, there is an obstruction
-                if (currentPiece != EMPTY && (currentPiece->getTeam() == startPosTeam || 
-                   (currentPiece->getTeam() == enemyTeam && startPos.rank != endPos.rank && startPos.file != endPos.file)))
-                    return false;
-            } 
-            while (startPos != endPos);
-
-            return true;
-        }
-    }
-    return false;
+    int startSquare = board.toSquare(startPos);
+    Bitboard occupied = board.occupancy();
+    Bitboard attacks = type == slideType::Rook ? Attacks::rookAttacks(startSquare, occupied) :
+                       type == slideType::Bishop ? Attacks::bishopAttacks(startSquare, occupied) :
+                                                   Attacks::queenAttacks(startSquare, occupied);
+
+    Team startPosTeam = board[startPos.rank][startPos.file]->getTeam();
+    return attacks & ~board.teamPieces(startPosTeam) & (Bitboard(1) << board.toSquare(endPos));
 }
 
 bool checkUtils::isOneTile(Position startPos, Position endPos) {
@@ -138,238 +121,83 @@ bool checkUtils::isOneTile(Position startPos, Position endPos) {
     return (xDiff == 1 && yDiff == 0) || (xDiff == 0 && yDiff == 1) || (xDiff == 1 && yDiff == 1);
 }
 
-void checkUtils::genMovesKing(const Board& board, Position startPos, std::vector<Move>& moves) {
-    for(int i = -1; i < 2; i++) {
-        for(int j = -1; j < 2; j++) {
-            Position tempPos(startPos.rank + i, startPos.file + j);
-            if(checkBounds(board, startPos, tempPos)) {
-                moves.push_back(Move(startPos, tempPos));
-            }
-        }
-    }
-}
+// Looks outward from the square with each piece's attack pattern and collects the matching enemy pieces there.
+// Sliders are traced through the given occupancy, so callers can test a position a move would leave behind
+Bitboard checkUtils::attackersTo(const Board& board, int square, Team byTeam, Bitboard occupied) {
+    Team defendingTeam = byTeam == Team::WHITE ? Team::BLACK : Team::WHITE;
+    Bitboard queens = board.pieces(byTeam, Type::QUEEN);
 
-void checkUtils::genMovesQueen(const Board& board, Position startPos, std::vector<Move>& moves) {
-    genSliding(board, startPos, slideType::Queen, moves);
+    return (Attacks::pawnAttacks(defendingTeam, square) & board.pieces(byTeam, Type::PAWN)) |
+           (Attacks::knightAttacks(square) & board.pieces(byTeam, Type::KNIGHT)) |
+           (Attacks::kingAttacks(square) & board.pieces(byTeam, Type::KING)) |
+           (Attacks::bishopAttacks(square, occupied) & (board.pieces(byTeam, Type::BISHOP) | queens)) |
+           (Attacks::rookAttacks(square, occupied) & (board.pieces(byTeam, Type::ROOK) | queens));
 }
 
-void checkUtils::genMovesRook(const Board& board, Position startPos, std::vector<Move>& moves) {
-    genSliding(board, startPos, slideType::Rook, moves);
+// The primitive behind checks and castling safety
+bool checkUtils::isSquareAttacked(const Board& board, int square, Team byTeam) {
+    return attackersTo(board, square, byTeam, board.occupancy()) != 0;
 }
 
-void checkUtils::genMovesBishop(const Board& board, Position startPos, std::vector<Move>& moves) {
-    genSliding(board, startPos, slideType::Bishop, moves);
-}
-
-void checkUtils::genMovesKnight(const Board& board, Position startPos, std::vector<Move>& moves) {
-    Team startPosTeam = board[startPos.rank][startPos.file]->getTeam();
-
-    for(size_t i{}; i < 8; i++) {
-        Position tempPos(startPos.rank + knightOffsets[i].rank, startPos.file + knightOffsets[i].file);
-        Piece* currentPiece = board[tempPos.rank][tempPos.file];
-        if(!checkBounds(board, startPos, tempPos)) continue;
-
-        // Valid move if moving to empty spot or enemy's spot
-        if((currentPiece == EMPTY) || (currentPiece->getTeam() != startPosTeam)) {
-            moves.push_back(Move(startPos, tempPos));
-        }
-    }
-}
-
-void checkUtils::genMovesPawn(const Board& board, Position startPos, std::vector<Move>& moves) {
-    Team startTeam = board[startPos.rank][startPos.file]->getTeam();
-
-    int rankMoveDirection = (board.getCurrentTurn() == Team::BLACK)
-                    ? (startTeam == Team::WHITE ? -1 : 1)
-                    : (startTeam == Team::WHITE ? 1 : -1);
-
-    for(size_t i{}; i < 4; i++) {
-        Position tempPos(startPos.rank + (pawnOffsets[i].rank * rankMoveDirection), startPos.file + pawnOffsets[i].file);
-        if(!checkBounds(board, startPos, tempPos)) continue;
-
-        // i indices represent the type of move from offset array
-        Piece* currentPiece = board[tempPos.rank][tempPos.file];
-        bool isSingleStep = (i == 0) && (currentPiece == EMPTY);
-        bool isDoubleStep = (i == 1) && (startPos.rank == 6) && (currentPiece == EMPTY);
-        bool isCapture = ((i == 2) || (i == 3)) && (currentPiece != EMPTY) && (currentPiece->getTeam() != startTeam);
-
-        if(isSingleStep || isDoubleStep || isCapture) {
-            moves.push_back(Move(startPos, tempPos));
-        }
-    }
-}
-
-void checkUtils::genSliding(const Board& board, Position startPos, slideType type, std::vector<Move>& moves) {
-    // Determine range of indexing arrays based on piece type
-    int start = type == slideType::Bishop ? 4 : 0;
-    int end = type == slideType::Rook ? 4 : 8;
-    Team startPosTeam = board[startPos.rank][startPos.file]->getTeam();
-
-    for(int i = start; i < end; i++) {
-        int rankDirection = slidingOffsets[i].rank;
-        int fileDirection = slidingOffsets[i].file;
-        Position tempPos(startPos.rank + rankDirection, startPos.file + fileDirection);
-
-        while(tempPos.file < 8 && tempPos.file >= 0 && tempPos.rank < 8 && tempPos.rank >= 0) {
-            Piece* currentPiece = board[tempPos.rank][tempPos.file];
-            // Empty Space
-            if(currentPiece == EMPTY) {
-                moves.push_back(Move(startPos, tempPos));
-            } // Obstructed by teammate
-            else if (currentPiece->getTeam() == startPosTeam) {
-                break;
-            } // Obstructed by enemy
-            else if (currentPiece->getTeam() != startPosTeam) {
-                moves.push_back(Move(startPos, tempPos));
-                break;
-            } 
-            else perror("Reached unknown state!\n");
-
-            tempPos.rank += rankDirection;
-            tempPos.file += fileDirection;
-        }
-    }
-}
-
-// Checks if any piece from opponent's team can move to King's position
+// Checks if any piece from opponent's team attacks the King's position
 bool checkUtils::isKingInCheck(const Board& board, Position kingPos, Team team) {
     Team enemyTeam = team == Team::WHITE ? Team::BLACK : Team::WHITE;
-    std::vector<Move> moves = Check::genAllMoves(board, enemyTeam);
-
-    // Check if any enemy moves reach King's position
-    for(const auto move : moves) {
-        if(move.endPos == kingPos) {
-            return true;
-        }
-    }
-    return false;
+    return isSquareAttacked(board, board.toSquare(kingPos), enemyTeam);
 }
 
 Position checkUtils::locateKing(const Board& board, Team team) {
-    for(size_t i{}; i < 8; i++) {
-        for(size_t j{}; j < 8; j++) {
-            if(board[j][i] != EMPTY && board[j][i]->getType() == Type::KING && board[j][i]->getTeam() == team)
-                return(Position(j,i));
-        }
-    }
-    perror("Unable to locate King\n");
-    return Position();
+    return board.toPosition(board.getKingSquare(team));
 }
 
-// Simulates a move and then determines if the King is in check
-bool checkUtils::isKingSafe(const Board& board, Position startPos, Position endPos) {
-    Board tempBoard(board);
-    tempBoard.grid[endPos.rank][endPos.file] = std::move(tempBoard.grid[startPos.rank][startPos.file]);
-    tempBoard.grid[startPos.rank][startPos.file] = EMPTY;
-
+// Plays the move on the board, determines if the King is in check, then takes the move back
+bool checkUtils::isKingSafe(Board& board, Position startPos, Position endPos) {
     Team currentTeam = board[startPos.rank][startPos.file]->getTeam();
-    Position kingPos = locateKing(tempBoard, currentTeam);
-    return(!isKingInCheck(tempBoard, kingPos, currentTeam));
-}
+    board.makeMove(Move(board.toSquare(startPos), board.toSquare(endPos)));
 
-std::string checkUtils::pieceToString(const Board& board, Position pos) {
-    std::string pieceName;
-    board[pos.rank][pos.file]->getTeam() == Team::WHITE ? pieceName += "white" : pieceName += "black";
-
-    Type pieceType = board[pos.rank][pos.file]->getType();
-    if(pieceType == Type::ROOK && pos == Position(7, 0)) {
-        pieceName += "LeftRook";
-    } else if (pieceType == Type::ROOK && pos == Position(7, 7)) {
-        pieceName += "RightRook";
-    } else if (pieceType == Type::KING) {
-        pieceName += "King";
-    } else {
-        pieceName.clear();
-    }
-    return pieceName;
-}
+    Position kingPos = locateKing(board, currentTeam);
+    bool isSafe = !isKingInCheck(board, kingPos, currentTeam);
 
-void checkUtils::castlingMark(Board& board, Position startPos) {
-    std::string pieceName = pieceToString(board, startPos);
-
-    if(!pieceName.empty()) {
-        auto it = board.castlingMap.find(pieceName);
-        if(it != board.castlingMap.end()) {
-            board.setMoved(pieceName);
-        }
-    }
+    board.unmakeMove();
+    return isSafe;
 }
 
 bool checkUtils::canCastle(const Board& board, Position startPos, Position endPos) {
-    Piece* startPiece = board[startPos.rank][startPos.file];
-    Piece* endPiece = board[endPos.rank][endPos.file];
-    if(startPiece == EMPTY || startPiece->getType() != Type::ROOK || endPiece->getType() != Type::KING || 
+    const Piece* startPiece = board[startPos.rank][startPos.file];
+    const Piece* endPiece = board[endPos.rank][endPos.file];
+    if(startPiece == EMPTY || endPiece == EMPTY || startPiece->getType() != Type::ROOK || endPiece->getType() != Type::KING ||
     startPiece->getTeam() != endPiece->getTeam()) return false;
 
-    std::string pieces[] {pieceToString(board, startPos), pieceToString(board, endPos)};
-    for(auto piece : pieces) {
-        if(!piece.empty()) {
-            auto it = board.castlingMap.find(piece);
-            if(it != board.castlingMap.end() && *(it->second) == true) {
-                return false;
-            }
-        }
+    // The Rook's home square decides which castling right is needed
+    uint8_t right;
+    switch(board.toSquare(startPos)) {
+        case 0:  right = Board::BLACK_QUEENSIDE; break;
+        case 7:  right = Board::BLACK_KINGSIDE; break;
+        case 56: right = Board::WHITE_QUEENSIDE; break;
+        case 63: right = Board::WHITE_KINGSIDE; break;
+        default: return false;
     }
+    if(!(board.getCastlingRights() & right)) return false;
 
     Position adjacentSpot(endPos.rank, startPos.file == 7 ? endPos.file + 1 : endPos.file - 1);
-    return checkSliding(board, startPos, adjacentSpot, slideType::Rook);
-}
-
-// Positions represent Rook's positions
-void checkUtils::performCastle(Board& board, Position startPos, Position endPos) {
-    castlingMark(board, startPos);
-    castlingMark(board, endPos);
+    if(board[adjacentSpot.rank][adjacentSpot.file] != EMPTY || !checkSliding(board, startPos, adjacentSpot, slideType::Rook)) return false;
 
-    Position adjacentSpot(endPos.rank, startPos.file == 7 ? endPos.file + 1 : endPos.file - 1); // where castled rook will go
-    Position kingPos = locateKing(board, board[startPos.rank][startPos.file]->getTeam());
+    // The King may not castle out of, through, or into check
+    Team enemyTeam = startPiece->getTeam() == Team::WHITE ? Team::BLACK : Team::WHITE;
     Position kingShift(adjacentSpot.rank, startPos.file == 7 ? adjacentSpot.file + 1 : adjacentSpot.file - 1);
-
-    shiftPiece(board, startPos, adjacentSpot);
-    shiftPiece(board, kingPos, kingShift);
-}
-
-void checkUtils::shiftPiece(Board& board, Position startPos, Position endPos) {
-    board.grid[endPos.rank][endPos.file] = std::move(board.grid[startPos.rank][startPos.file]);
-    board.grid[startPos.rank][startPos.file] = EMPTY;
+    for(Position pos : {endPos, adjacentSpot, kingShift}) {
+        if(isSquareAttacked(board, board.toSquare(pos), enemyTeam)) return false;
+    }
+    return true;
 }
 
 // Note: Check that both start and endpos are not null
 bool checkUtils::isCastlingMove(const Board& board, Position startPos, Position endPos) {
-    Piece* startPiece = board[startPos.rank][startPos.file];
-    Piece* endPiece = board[endPos.rank][endPos.file];
+    const Piece* startPiece = board[startPos.rank][startPos.file];
+    const Piece* endPiece = board[endPos.rank][endPos.file];
     if(startPiece == EMPTY || endPiece == EMPTY) return false;
 
     if(startPiece->getType() == Type::ROOK && endPiece->getType() == Type::KING && startPiece->getTeam() == endPiece->getTeam()) {
         return true;
     }
     return false;
-}
-
-// If any Pawn reaches other side, promote it to a Queen
-void checkUtils::pawnPromotion(Board& board) {
-    const int ranks[] = {0, 7};
-    for(const auto rank : ranks) {
-        for (size_t i{}; i < 8; i++) {
-            if(board[rank][i] != EMPTY && board[rank][i]->getType() == Type::PAWN) {
-                board[rank][i]->setType(Type::QUEEN);
-            } 
-        }
-    }
-}
-
-void checkUtils::assertWinner(const Team winningTeam) {
-    GUI::drawWinner(winningTeam);
-    GUI::onUpdate();
-    SDL_Event event;
-
-    bool status = true;
-    while(status) {
-        while(SDL_PollEvent(&event)) {
-            if(event.type == SDL_QUIT) {
-                status = false;
-                break;
-            }
-        }
-    }
-    return;
 }
\ No newline at end of file
@@ -1,13 +1,8 @@
 #pragma once
 
 #include "Board.hpp"
-#include "Game.hpp"
 #include "Check.hpp"
-#include "GUI.hpp"
 #include <string>
-#include <vector>
-#include <unordered_map>
-#include <functional>
 
 enum class slideType {
     Rook, Bishop, Queen
@@ -15,20 +10,7 @@ enum class slideType {
 
 namespace checkUtils {
 
-using canMoveFunction = std::function<bool(const Board&, Position, Position)>;
-using genMoveFunction = std::function<void(const Board&, Position, std::vector<Move>&)>;
-
-// Indexing arrays for Knight moves
-static const Position knightOffsets[] = {Position(2, 1), Position(1, 2), Position(2, -1), Position(1, -2),
-                                         Position(-2, 1), Position(-1, 2), Position(-2, -1), Position(-1, -2)};
-
-// Rook(0-3), bishop(4-7), and Queen(0-7)
-static const Position slidingOffsets[] = {Position(0, 1), Position(0, -1), Position(1, 0), Position(-1, 0),
-                                          Position(1, 1), Position(-1, 1), Position(1, -1), Position(-1, -1)}; 
-
-// Single-Step(0), Double-Step(1), and Captures(2-3)
-static const Position pawnOffsets[] = {Position(-1, 0), Position(-2, 0), Position(-1, 1), Position(-1, -1)};
-
+using canMoveFunction = bool (*)(const Board&, Position, Position);
 
 // Move Checks
 bool canMoveKing(const Board& board, Position startPos, Position endPos);
@@ -43,41 +25,26 @@ bool checkAxially(Position startPos, Position endPos);
 bool checkSliding(const Board& board, Position startPos, Position endPos, slideType type);
 bool isOneTile(Position startPos, Position endPos);
 
-// Move Generation
-void genMovesKing(const Board& board, Position startPos, std::vector<Move>& moves);
-void genMovesQueen(const Board& board, Position startPos, std::vector<Move>& moves);
-void genMovesRook(const Board& board, Position startPos, std::vector<Move>& moves);
-void genMovesKnight(const Board& board, Position startPos, std::vector<Move>& moves);
-void genMovesBishop(const Board& board, Position startPos, std::vector<Move>& moves);
-void genMovesPawn(const Board& board, Position startPos, std::vector<Move>& moves);
-void genSliding(const Board& board, Position startPos, slideType type, std::vector<Move>& moves);
-
 // Misc Functions
+Bitboard attackersTo(const Board& board, int square, Team byTeam, Bitboard occupied);
+bool isSquareAttacked(const Board& board, int square, Team byTeam);
 bool isKingInCheck(const Board& board, Position kingPos, Team team);
 Position locateKing(const Board& board, Team team);
-bool isKingSafe(const Board& board, Position startPos, Position endPos);
-void castlingMark(Board& board, Position startPos);
+bool isKingSafe(Board& board, Position startPos, Position endPos);
 bool canCastle(const Board& board, Position startPos, Position endPos);
-std::string pieceToString(const Board& board, Position pos);
-void performCastle(Board& board, Position startPos, Position endPos);
-void shiftPiece(Board& board, Position startPos, Position endPos);
 bool isCastlingMove(const Board& board, Position startPos, Position endPos);
-void pawnPromotion(Board& board);
-void assertWinner(const Team winningTeam);
 
-static std::unordered_map<Type, canMoveFunction> canMoveFunctions = {
-    {Type::KING, canMoveKing},
-    {Type::QUEEN, canMoveQueen},
-    {Type::ROOK, canMoveRook},
-    {Type::KNIGHT, canMoveKnight},
-    {Type::BISHOP, canMoveBishop},
-    {Type::PAWN, canMovePawn}};
+// Jump table indexed by Type, in the order the enum declares the pieces. It is fixed at compile time, so
+// dispatching on a piece is one array load and a direct call. It backs Check::canMoveToSpot, which checks the
+// single move a player enters; the search and perft use the legal move generator instead
+constexpr canMoveFunction canMoveFunctions[] = {
+    canMoveKing, canMoveQueen, canMoveRook, canMoveKnight, canMoveBishop, canMovePawn};
+
+static_assert(static_cast<int>(Type::KING) == 0 && static_cast<int>(Type::PAWN) == 5,
+              "The dispatch table follows the order of Type");
 
-static std::unordered_map<Type, genMoveFunction> genMoveFunctions = {
-    {Type::KING, genMovesKing},
-    {Type::QUEEN, genMovesQueen},
-    {Type::ROOK, genMovesRook},
-    {Type::KNIGHT, genMovesKnight},
-    {Type::BISHOP, genMovesBishop},
-    {Type::PAWN, genMovesPawn}};
+// Whether the piece on startPos can reach endPos by its own movement rules. Does not check for King safety
+inline bool canMove(const Board& board, Position startPos, Position endPos) {
+    return canMoveFunctions[static_cast<int>(board[startPos.rank][startPos.file]->getType())](board, startPos, endPos);
+}
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "GUI.hpp"
-#include "CheckUtils.hpp"
 #include "Check.hpp"
 #include <iostream>
+#include <algorithm>
 
 SDL_Window* GUI::window = nullptr;
 SDL_Renderer* GUI::renderer = nullptr;
@@ -107,44 +107,49 @@ void GUI::drawLetters(Team team) {
     }
 }
 
-void GUI::drawBoard(const Board& board) {
+// The Board keeps White at the bottom of its grid. Seen from Black the grid is turned around, which maps a
+// Position to the opposite corner. The same mapping takes a clicked tile back to the Board's Position
+Position GUI::toScreen(Position pos, Team perspective) {
+    if(perspective == Team::BLACK) return Position(7 - pos.rank, 7 - pos.file);
+    return pos;
+}
+
+// Tiles and letters follow the team drawn at the bottom, like the pieces
+void GUI::drawBoard(const Board& board, Team perspective) {
     drawBackground();
-    drawTiles(board.getCurrentTurn());
-    drawLetters(board.getCurrentTurn());
+    drawTiles(perspective);
+    drawLetters(perspective);
     for(size_t i{}; i < 8; i++) {
         for(size_t j{}; j < 8; j++) {
             if(board[i][j] != EMPTY) {
-                drawPiece(i, j, board[i][j]->getTeam(), board[i][j]->getType());
+                Position screenPos = toScreen(Position(i, j), perspective);
+                drawPiece(screenPos.rank, screenPos.file, board[i][j]->getTeam(), board[i][j]->getType());
             }
         }
     }
 }
 
-void GUI::drawMoves(const Board& board, Position piecePos) {
-    using namespace checkUtils;
-
-    std::vector<Move> moves;
-    Piece* piece = board[piecePos.rank][piecePos.file];
-    if(piece == EMPTY) return;
-
-    auto it = genMoveFunctions.find(piece->getType());
-    if(it != genMoveFunctions.end()) {
-        it->second(board, piecePos, moves);
+// Highlights come from the legal move generator, so castling and en passant targets show up too. The four
+// promotions of a Pawn share a target square, so targets are collected first and each is drawn once
+void GUI::drawMoves(const Board& board, Position piecePos, Team perspective) {
+    int from = Board::toSquare(piecePos);
+    Bitboard targets = 0;
+    for(const Move& move : Check::genAllSafeMoves(board, board.getCurrentTurn())) {
+        if(move.from() == from) targets |= Bitboard(1) << move.to();
     }
 
     SDL_Rect dstRect;
-    for(const auto& move : moves) {
-        if(Check::canMoveToSpot(board, move.startPos, move.endPos)) {
-            dstRect.x = GUIConstants::tileOffset + (move.endPos.file * GUIConstants::tileDimensions);
-            dstRect.y = GUIConstants::tileOffset + (move.endPos.rank * GUIConstants::tileDimensions);
-            dstRect.w = GUIConstants::tileDimensions;
-            dstRect.h = GUIConstants::tileDimensions;
-            SDL_RenderCopy(renderer, overlay, NULL, &dstRect);
-        }
+    while(targets) {
+        Position screenPos = toScreen(Board::toPosition(popLsb(targets)), perspective);
+        dstRect.x = GUIConstants::tileOffset + (screenPos.file * GUIConstants::tileDimensions);
+        dstRect.y = GUIConstants::tileOffset + (screenPos.rank * GUIConstants::tileDimensions);
+        dstRect.w = GUIConstants::tileDimensions;
+        dstRect.h = GUIConstants::tileDimensions;
+        SDL_RenderCopy(renderer, overlay, NULL, &dstRect);
     }
 }
 
-Position GUI::evaluateClick(const SDL_Event& event, Team team) {
+Position GUI::evaluateClick(const SDL_Event& event, Team perspective) {
     int x_val {event.button.x};
     int y_val {event.button.y};
 
@@ -154,12 +159,7 @@ Position GUI::evaluateClick(const SDL_Event& event, Team team) {
     int j = static_cast<int>((x_val - 25)/100);
     int i = static_cast<int>((y_val - 25)/100);
 
-    Position pos(i, j);
-    if(team == Team::BLACK) {
-        pos.rank = 7 - pos.rank;
-        pos.file = 7 - pos.file;
-    }
-    return pos;
+    return toScreen(Position(i, j), perspective);
 }
 
 void GUI::drawPiece(int x, int y, Team team, Type pieceType) {
@@ -180,12 +180,25 @@ void GUI::drawWinner(Team winningTeam) {
     SDL_QueryTexture(bgWin, NULL, NULL, &(dstRect.w), &(dstRect.h));
     SDL_RenderCopy(renderer, bgWin, NULL, &dstRect);
 
-    // Render name of winning Team
+    // Render name of winning Team. The board is redrawn whenever the window is uncovered, so release the last texture
+    if(winTeam != nullptr) SDL_DestroyTexture(winTeam);
     winTeam = winningTeam == Team::WHITE ? SDL_CreateTextureFromSurface(renderer, SDL_LoadBMP("../assets/White.bmp")) :
                                      SDL_CreateTextureFromSurface(renderer, SDL_LoadBMP("../assets/Black.bmp"));
     SDL_RenderCopy(renderer, winTeam, NULL, &dstRect);
 }
 
+// Bar in the top margin that fills up as the AI uses its thinking time
+void GUI::drawThinking(double progress) {
+    SDL_Rect barRect;
+    barRect.x = GUIConstants::tileOffset;
+    barRect.y = (GUIConstants::tileOffset - GUIConstants::thinkingBarHeight) / 2;
+    barRect.w = static_cast<int>(8 * GUIConstants::tileDimensions * std::min(std::max(progress, 0.0), 1.0));
+    barRect.h = GUIConstants::thinkingBarHeight;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, GUIConstants::overlayOpacity);
+    SDL_RenderFillRect(renderer, &barRect);
+}
+
 void GUI::onUpdate() {
     SDL_RenderPresent(renderer);
 }
@@ -11,6 +11,7 @@ namespace GUIConstants {
     constexpr int winBgOffset = 200;
     constexpr int tileDimensions = 100;
     constexpr Uint8 overlayOpacity = 156;
+    constexpr int thinkingBarHeight = 8;
 }
 
 class GUI {
@@ -21,16 +22,18 @@ class GUI {
 
     static SDL_Rect findPiece(Team team, Type pieceType);
     static void drawPiece(int x, int y, Team team, Type pieceType);
+    static Position toScreen(Position pos, Team perspective);
 
     public:
     static void initialize();
-    static Position evaluateClick(const SDL_Event& event, Team team);
+    static Position evaluateClick(const SDL_Event& event, Team perspective);
     static void drawBackground();
     static void drawTiles(Team team);
     static void drawLetters(Team team);
-    static void drawBoard(const Board& board);
-    static void drawMoves(const Board& board, Position piecePos);
+    static void drawBoard(const Board& board, Team perspective);
+    static void drawMoves(const Board& board, Position piecePos, Team perspective);
     static void drawWinner(Team winningTeam);
+    static void drawThinking(double progress);
     static void onUpdate();
     static void exit();
 };
@@ -1,95 +1,174 @@
 #include "Game.hpp"
 #include "Check.hpp"
+#include "CheckUtils.hpp"
 #include "AI.hpp"
 #include "GUI.hpp"
 #include <iostream>
-#include <queue>
 
-// Primary Game Loop
+// Longest time the loop sleeps without an event. While the AI thinks it wakes more often to animate the progress bar
+static constexpr int eventTimeoutMs = 500;
+static constexpr int thinkingFrameMs = 50;
+
+// Primary Game Loop. It sleeps in SDL_WaitEventTimeout until something happens and redraws only when the
+// position, the selection or the window contents changed, so an idle game uses almost no CPU
 void Game::startGame() {
     GUI::initialize();
-    GUI::drawBoard(this->board.getCurrentTurn());
-    GUI::onUpdate();
+    srand(static_cast<int>(time(0)));
+    aiMoveEvent = SDL_RegisterEvents(1);
 
-    std::queue<Position> moveQueue;
     SDL_Event event;
-    bool selected = false;
-    srand(static_cast<int>(time(0)));
+    bool redraw = true;
+    bool running = true;
+    while(running) {
+        if(redraw) {
+            render();
+            redraw = false;
+        }
 
-    // This should check for a win condition
-    while(!Check::isCheckMate(board)) {
-
-        bool status = true;
-        while(status) {
-            while(SDL_PollEvent(&event)) {
-                switch(event.type) {
-                    case SDL_QUIT:
-                        return;
-                    case SDL_MOUSEBUTTONDOWN:
-                        Position boardPos = GUI::evaluateClick(event, this->board.getCurrentTurn());
-                        if(boardPos == INVALID_POS) {
-                            continue;
-                        } else {
-                            status = false;
-                            moveQueue.push(boardPos);
-                            break;
-                        }
-                }
+        if(!SDL_WaitEventTimeout(&event, thinking ? thinkingFrameMs : eventTimeoutMs)) {
+            redraw = thinking;
+            continue;
+        }
+        if(event.type == aiMoveEvent) {
+            // A ponder search that ends by itself before the player moves keeps its move for the ponder hit
+            if(pondering) {
+                ponderResult = event.user.code;
+            } else {
+                applyAIMove(event.user.code);
+                redraw = true;
             }
+            continue;
+        }
+        switch(event.type) {
+            case SDL_QUIT:
+                running = false;
+                break;
+            case SDL_WINDOWEVENT:
+                // The window was uncovered and its contents have to be painted again
+                if(event.window.event == SDL_WINDOWEVENT_EXPOSED) redraw = true;
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+                redraw = handleClick(event);
+                break;
         }
+    }
 
+    // Quitting mid-search stops the worker at its next limit check
+    AI::stopSearch();
+    AI::waitForSearch();
+    GUI::exit();
+}
 
-        if(moveQueue.size() == 1) {
-            Position pos = moveQueue.front();
-            if(board[pos.rank][pos.file] == EMPTY || board[pos.rank][pos.file]->getTeam() != board.getCurrentTurn()) {
-                moveQueue.pop();
-                GUI::drawBoard(board);
-                GUI::onUpdate();
-                continue;
-            }
-            if(board.getCurrentTurn() == Team::BLACK) {
-                pos.file = 7 - pos.file;
-                pos.rank = 7 - pos.rank;
-            }
-            if(board[pos.rank][pos.file] != EMPTY && board.getCurrentTurn() == board[pos.rank][pos.file]->getTeam()) {
-                GUI::drawMoves(board, pos);
-                GUI::onUpdate();
-            }
-        } else if(moveQueue.size() == 2) {
-            Position startPos = moveQueue.front();
-            Position endPos = moveQueue.back();
-            while (!moveQueue.empty()) moveQueue.pop();
-
-            if(!board.movePiece(startPos, endPos)) {
-                while (!moveQueue.empty()) moveQueue.pop();
-                GUI::drawBoard(this->board);
-                GUI::onUpdate();
-                continue;
-            }
+// The first click selects one of the player's pieces and shows its moves, the second tries to move it there.
+// Returns whether anything on screen changed
+bool Game::handleClick(const SDL_Event& event) {
+    if(gameOver || thinking) return false;
 
-            GUI::drawBoard(this->board);
-            GUI::onUpdate();
+    Position clickPos = GUI::evaluateClick(event, perspective);
+    if(clickPos == INVALID_POS) return false;
 
-            board.changeTurns();
-            board.rotateBoard();
+    if(selectedPos == INVALID_POS) {
+        const Piece* piece = board[clickPos.rank][clickPos.file];
+        if(piece == EMPTY || piece->getTeam() != board.getCurrentTurn()) return false;
+        selectedPos = clickPos;
+        return true;
+    }
+
+    Position startPos = selectedPos;
+    selectedPos = INVALID_POS;
+    if(!board.movePiece(startPos, clickPos)) return true;
+
+    if(!updateGameOver()) startAIMove();
+    return true;
+}
 
-            Move bestMove;
-            if(randMoves-- <= 0) {
-                bestMove = AI::genAIMove(board, 2, board.getCurrentTurn());
+void Game::startAIMove() {
+    if(pondering) {
+        pondering = false;
+        if(board.getHashKey() == ponderKey) {
+            // Ponder hit: the running search is already on this position and its time limit starts now
+            AI::ponderHit();
+            if(ponderResult >= 0) {
+                applyAIMove(ponderResult);
             } else {
-                bestMove = AI::genRandomMove(board, board.getCurrentTurn());
+                thinking = true;
+                thinkingSince = SDL_GetTicks();
             }
+            return;
+        }
 
-            if(bestMove == INVALID_MOVE) break;
-            checkUtils::shiftPiece(board, bestMove.startPos, bestMove.endPos);
-            checkUtils::pawnPromotion(board);
-
-            board.changeTurns();
-            board.rotateBoard();
+        // Ponder miss: drop the search and the move it posts. What it stored in the transposition table still helps
+        AI::stopSearch();
+        AI::waitForSearch();
+        SDL_FlushEvent(aiMoveEvent);
+    }
 
-            GUI::drawBoard(this->board);
-            GUI::onUpdate();
-        }
+    if(randMoves-- > 0) {
+        Move move = AI::genRandomMove(board, board.getCurrentTurn());
+        applyAIMove(move.data);
+        return;
     }
-    GUI::exit();
+
+    thinking = true;
+    thinkingSince = SDL_GetTicks();
+    launchSearch(board, false);
+}
+
+// While the player thinks, the AI searches the reply its last search expects, taken from the transposition table
+void Game::startPondering() {
+    if(randMoves > 0) return;
+    Move expectedMove = AI::getHashMove(board);
+    if(expectedMove == INVALID_MOVE) return;
+
+    Board aiBoard(board);
+    aiBoard.playMove(expectedMove);
+    if(Check::genAllSafeMoves(aiBoard, aiBoard.getCurrentTurn()).empty()) return;
+
+    pondering = true;
+    ponderKey = aiBoard.getHashKey();
+    ponderResult = -1;
+    launchSearch(aiBoard, true);
 }
+
+// Its move travels back in an SDL event as its 16 bits of data, so the worker never touches
+// the board being drawn
+void Game::launchSearch(const Board& aiBoard, bool ponder) {
+    AI::SearchLimits limits;
+    limits.timeMs = aiMoveTime;
+    limits.ponder = ponder;
+    uint32_t eventType = aiMoveEvent;
+    AI::startSearch(aiBoard, limits, aiBoard.getCurrentTurn(), [eventType](Move move) {
+        SDL_Event event = {};
+        event.type = eventType;
+        event.user.code = move.data;
+        SDL_PushEvent(&event);
+    });
+}
+
+void Game::applyAIMove(int encodedMove) {
+    thinking = false;
+    Move move;
+    move.data = static_cast<uint16_t>(encodedMove);
+    board.playMove(move);
+    if(!updateGameOver()) startPondering();
+}
+
+// The game ends when the team to move has no legal moves: checkmate if its King is attacked, stalemate otherwise
+bool Game::updateGameOver() {
+    Team team = board.getCurrentTurn();
+    if(!Check::genAllSafeMoves(board, team).empty()) return false;
+
+    Team enemyTeam = team == Team::WHITE ? Team::BLACK : Team::WHITE;
+    gameOver = true;
+    checkmate = checkUtils::isSquareAttacked(board, board.getKingSquare(team), enemyTeam);
+    winner = enemyTeam;
+    return true;
+}
+
+void Game::render() {
+    GUI::drawBoard(board, perspective);
+    if(selectedPos != INVALID_POS) GUI::drawMoves(board, selectedPos, perspective);
+    if(thinking) GUI::drawThinking(static_cast<double>(SDL_GetTicks() - thinkingSince) / aiMoveTime);
+    if(checkmate) GUI::drawWinner(winner);
+    GUI::onUpdate();
+}
\ No newline at end of file
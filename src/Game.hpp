@@ -3,13 +3,38 @@
 #include "Board.hpp"
 #include <time.h>
 #include <cstdlib>
+#include <cstdint>
+
+union SDL_Event;
 
 class Game {
     private:
     Board board;
+    Team perspective; // Team drawn at the bottom of the window
     int randMoves; // Number of times we want to play initial random moves
+    int aiMoveTime; // Milliseconds the AI may think per move
+    Position selectedPos; // Piece picked by the first click, INVALID_POS if none
+    bool gameOver;
+    bool checkmate; // Whether the game ended with a winner rather than a stalemate
+    Team winner;
+    bool thinking; // The AI is searching on its worker thread
+    uint32_t thinkingSince; // SDL ticks when the search started, for the progress bar
+    uint32_t aiMoveEvent; // SDL event type the worker posts its move with
+    bool pondering; // The AI is searching the player's expected move while the player thinks
+    uint64_t ponderKey; // Hash of the position after the expected move
+    int ponderResult; // Move of a ponder search that ended before the player moved, -1 if none
+
+    bool handleClick(const SDL_Event& event);
+    void startAIMove();
+    void startPondering();
+    void launchSearch(const Board& aiBoard, bool ponder);
+    void applyAIMove(int encodedMove);
+    bool updateGameOver();
+    void render();
 
     public:
-    Game(Team team) : board(team), randMoves(3) {};
+    Game(Team team) : board(team), perspective(team), randMoves(3), aiMoveTime(1000), selectedPos(INVALID_POS),
+                      gameOver(false), checkmate(false), winner(team), thinking(false), thinkingSince(0), aiMoveEvent(0),
+                      pondering(false), ponderKey(0), ponderResult(-1) {};
     void startGame();
 };
\ No newline at end of file
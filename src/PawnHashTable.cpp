@@ -0,0 +1,44 @@
+#include "PawnHashTable.hpp"
+
+// Bit 32 of the data marks a used slot, so a stored entry is never 0 even when both scores are
+static constexpr uint64_t USED = uint64_t(1) << 32;
+
+// The entry count is rounded down to a power of two so the slot is found with a mask
+PawnHashTable::PawnHashTable(size_t entries) : slotCount(1) {
+    while(slotCount * 2 <= entries) slotCount *= 2;
+    slots.reset(new Slot[slotCount]);
+    clear();
+}
+
+// Must not run while a search is using the table
+void PawnHashTable::clear() {
+    for(size_t i{}; i < slotCount; i++) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Empty slots and slots holding another pawn structure both count as misses
+bool PawnHashTable::probe(uint64_t key, Entry& entry, Stats& stats) const {
+    const Slot& slot = slots[key & (slotCount - 1)];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if(data == 0 || (check ^ data) != key) {
+        stats.misses++;
+        return false;
+    }
+    stats.hits++;
+    entry.middlegame = static_cast<int16_t>(data & 0xFFFF);
+    entry.endgame = static_cast<int16_t>((data >> 16) & 0xFFFF);
+    return true;
+}
+
+// Always replaces: pawn scores do not depend on search depth
+void PawnHashTable::store(uint64_t key, const Entry& entry) {
+    uint64_t data = static_cast<uint64_t>(static_cast<uint16_t>(entry.middlegame)) |
+                    static_cast<uint64_t>(static_cast<uint16_t>(entry.endgame)) << 16 | USED;
+    Slot& slot = slots[key & (slotCount - 1)];
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
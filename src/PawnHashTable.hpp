@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+// Cache of pawn-structure scores keyed by Board::getPawnKey(), shared by all search threads. Pawns move rarely
+// during a search, so most evaluations find their pawn terms here. Slots use the same key ^ data check as the
+// transposition table, so a slot torn by two threads reads as a collision
+class PawnHashTable {
+    public:
+    struct Entry {
+        int16_t middlegame, endgame; // White minus Black, in centipawns
+    };
+
+    // Counted by the caller so each search thread can keep its own
+    struct Stats {
+        uint64_t hits, misses;
+    };
+
+    explicit PawnHashTable(size_t entries);
+    void clear();
+    bool probe(uint64_t key, Entry& entry, Stats& stats) const;
+    void store(uint64_t key, const Entry& entry);
+
+    private:
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t slotCount;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <cstddef>
+
 #define EMPTY nullptr
 
 enum class Team : int {
@@ -13,8 +16,8 @@ enum class Type {
 
 struct Position {
     int rank, file;
-    Position(int rank, int file);
-    Position();
+    Position(int r, int f) : rank(r), file(f) {}
+    Position() : rank(-1), file(-1) {}
     
     bool operator==(const Position& other) const {
         return rank == other.rank && file == other.file;
@@ -25,17 +28,64 @@ struct Position {
 };
 static const Position INVALID_POS(-1,-1); 
 
+// A move packed into 16 bits: from square (bits 0-5), to square (bits 6-11) and flags (bits 12-15). Squares are
+// absolute, a8 = 0 ... h1 = 63. Bits 14-15 hold the new piece of a promotion, and otherwise mark castling or
+// en passant. The default constructor leaves the move uninitialized so move lists cost nothing to create
 struct Move {
-    Position startPos, endPos;
-    Move(Position start, Position end);
-    Move();
-    Move(const Move& move);
+    enum Flags : uint16_t {
+        CAPTURE = 1 << 12,
+        PROMOTION = 1 << 13,
+        CASTLING = 1 << 14,
+        EN_PASSANT = 2 << 14
+    };
+
+    uint16_t data;
+
+    Move() = default;
+    constexpr Move(int from, int to, uint16_t flags = 0) : data(static_cast<uint16_t>(from | to << 6 | flags)) {}
 
-    bool operator==(const Move& other) const {
-        return (startPos == other.startPos && endPos == other.endPos);
+    // Queen, Rook, Knight and Bishop follow each other in Type, so the piece is stored as its offset from the Queen
+    static constexpr Move promotion(int from, int to, Type type, bool capture) {
+        return Move(from, to, static_cast<uint16_t>(PROMOTION | (capture ? CAPTURE : 0) |
+                                                    (static_cast<int>(type) - static_cast<int>(Type::QUEEN)) << 14));
     }
+
+    int from() const {return data & 63;}
+    int to() const {return (data >> 6) & 63;}
+    bool isCapture() const {return data & CAPTURE;}
+    bool isPromotion() const {return data & PROMOTION;}
+    bool isCastling() const {return (data & (PROMOTION | 3 << 14)) == CASTLING;}
+    bool isEnPassant() const {return (data & (PROMOTION | 3 << 14)) == EN_PASSANT;}
+    Type promotionType() const {return static_cast<Type>(static_cast<int>(Type::QUEEN) + (data >> 14));}
+
+    bool operator==(const Move& other) const {return data == other.data;}
+    bool operator!=(const Move& other) const {return data != other.data;}
+};
+static constexpr Move INVALID_MOVE(0, 0); // a8 to a8 is never a legal move
+
+// Fixed-capacity move list on the stack, so generating moves never allocates. No position has more than 218
+// legal moves
+class MoveList {
+    public:
+    static constexpr size_t CAPACITY = 256;
+
+    MoveList() : count(0) {}
+    void push_back(Move move) {moves[count++] = move;}
+    size_t size() const {return count;}
+    bool empty() const {return count == 0;}
+    Move& operator[](size_t index) {return moves[index];}
+    const Move& operator[](size_t index) const {return moves[index];}
+    Move& front() {return moves[0];}
+    const Move& front() const {return moves[0];}
+    Move* begin() {return moves;}
+    Move* end() {return moves + count;}
+    const Move* begin() const {return moves;}
+    const Move* end() const {return moves + count;}
+
+    private:
+    Move moves[CAPACITY];
+    size_t count;
 };
-static const Move INVALID_MOVE(INVALID_POS, INVALID_POS);
 
 class Piece {
     private:
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Material plus piece-square bonuses for the middlegame and the endgame. Board sums them incrementally, so the
+// evaluation only blends the two totals by the game phase
+namespace PieceSquare {
+    struct Tables {
+        int16_t middlegame[12][64]; // [team * 6 + type][square], positive for White and negative for Black
+        int16_t endgame[12][64];
+    };
+
+    // Phase weight per type in Type order. The phase counts down from MAX_PHASE as pieces leave the board
+    constexpr int phaseWeights[6] = {0, 4, 2, 1, 1, 0};
+    constexpr int MAX_PHASE = 24;
+
+    extern const Tables tables;
+};
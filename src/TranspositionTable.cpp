@@ -0,0 +1,84 @@
+#include "TranspositionTable.hpp"
+
+TranspositionTable::TranspositionTable(size_t megabytes) : slotCount(0) {
+    resize(megabytes);
+}
+
+// Rounds down to the largest power-of-two entry count that fits in the requested size
+void TranspositionTable::resize(size_t megabytes) {
+    size_t bytes = (megabytes ? megabytes : 1) * 1024 * 1024;
+    size_t count = 1;
+    while(count * 2 * sizeof(Slot) <= bytes) count *= 2;
+
+    slots.reset(new Slot[count]);
+    slotCount = count;
+    clear();
+}
+
+// Must not run while a search is using the table
+void TranspositionTable::clear() {
+    for(size_t i{}; i < slotCount; i++) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// A miss is an empty slot, a collision is a slot holding a different (or torn) position
+bool TranspositionTable::probe(uint64_t key, Entry& entry, Stats& stats) const {
+    const Slot& slot = slots[key & (slotCount - 1)];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if(data == 0) {
+        stats.misses++;
+        return false;
+    }
+    if((check ^ data) != key) {
+        stats.collisions++;
+        return false;
+    }
+    stats.hits++;
+    entry = unpack(data);
+    return true;
+}
+
+// Keeps the deeper result when the same position is stored twice, otherwise always replaces
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, Move move) {
+    Slot& slot = slots[key & (slotCount - 1)];
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    bool samePosition = oldData != 0 && (slot.check.load(std::memory_order_relaxed) ^ oldData) == key;
+
+    Entry entry{score, static_cast<int8_t>(depth), bound, move};
+    if(samePosition) {
+        Entry old = unpack(oldData);
+        if(old.depth > depth && bound != Bound::EXACT) return;
+
+        // Keep the old best move if this result did not find one
+        if(move == INVALID_MOVE) entry.move = old.move;
+    }
+
+    uint64_t data = pack(entry);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+size_t TranspositionTable::getSizeMB() const {
+    return slotCount * sizeof(Slot) / (1024 * 1024);
+}
+
+// score | depth << 32 | bound << 40 | move << 48. Bound is never NONE, so stored data is never 0
+uint64_t TranspositionTable::pack(const Entry& entry) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(entry.score)) |
+           static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 32 |
+           static_cast<uint64_t>(entry.bound) << 40 |
+           static_cast<uint64_t>(entry.move.data) << 48;
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(uint64_t data) {
+    Entry entry;
+    entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+    entry.depth = static_cast<int8_t>(data >> 32);
+    entry.bound = static_cast<Bound>((data >> 40) & 0xFF);
+    entry.move.data = static_cast<uint16_t>(data >> 48);
+    return entry;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include "Piece.hpp"
+
+// Fixed-size hash table of search results keyed by Board::getHashKey(), shared by all search threads.
+// The entry count is a power of two so the slot is found with a mask instead of a modulo.
+// Slots are lock-free: each stores its data word and the key XOR data, so a slot torn by two
+// threads writing at once fails validation and reads as a collision instead of returning bad data
+class TranspositionTable {
+    public:
+    enum class Bound : uint8_t {
+        NONE, EXACT, LOWER, UPPER
+    };
+
+    struct Entry {
+        int32_t score;
+        int8_t depth;
+        Bound bound;
+        Move move; // Best move, INVALID_MOVE if there is none
+    };
+
+    // Counted by the caller so each search thread can keep its own
+    struct Stats {
+        uint64_t hits, misses, collisions;
+    };
+
+    explicit TranspositionTable(size_t megabytes);
+    void resize(size_t megabytes);
+    void clear();
+    bool probe(uint64_t key, Entry& entry, Stats& stats) const;
+    void store(uint64_t key, int depth, Bound bound, int score, Move move);
+    size_t getSizeMB() const;
+
+    private:
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t slotCount;
+
+    static uint64_t pack(const Entry& entry);
+    static Entry unpack(uint64_t data);
+};
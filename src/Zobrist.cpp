@@ -0,0 +1,30 @@
+#include "Zobrist.hpp"
+
+// SplitMix64 with a fixed seed so keys (and therefore searches) are reproducible between runs
+static constexpr uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static constexpr Zobrist::Keys generateKeys() {
+    Zobrist::Keys keys{};
+    uint64_t state = 0x22C4E55ULL;
+    for(int piece = 0; piece < 12; piece++) {
+        for(int square = 0; square < 64; square++) {
+            keys.pieces[piece][square] = nextRandom(state);
+        }
+    }
+    for(int rights = 0; rights < 16; rights++) {
+        keys.castling[rights] = nextRandom(state);
+    }
+    keys.blackToMove = nextRandom(state);
+    for(int file = 0; file < 8; file++) {
+        keys.enPassant[file] = nextRandom(state);
+    }
+    return keys;
+}
+
+// Constant-initialized, so the keys are ready before any static Board is constructed
+const Zobrist::Keys Zobrist::keys = generateKeys();
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Random keys XORed together to identify a position. Board keeps its key up to date on every change
+namespace Zobrist {
+    struct Keys {
+        uint64_t pieces[12][64]; // [team * 6 + type][square]
+        uint64_t castling[16];   // indexed by the castling rights mask
+        uint64_t blackToMove;
+        uint64_t enPassant[8];   // indexed by the file of the en passant square
+    };
+
+    extern const Keys keys;
+};
@@ -0,0 +1,193 @@
+#include "AI.hpp"
+#include "Check.hpp"
+#include "CheckUtils.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+// Fixed benchmark positions, reached from the starting position by coordinate moves
+static const char* benchPositions[] = {
+    "",
+    "e2e4 e7e5 g1f3 b8c6 f1c4 g8f6",
+    "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6 c1g5 f8e7",
+    "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6",
+    "e2e4 e7e6 d2d4 d7d5 b1c3 f8b4 e4e5 c7c5 a2a3 b4c3 b2c3",
+};
+
+// Plays a move such as "e2e4" if it is legal
+static bool playMove(Board& board, const std::string& text) {
+    if(text.size() < 4) return false;
+    int from = ('8' - text[1]) * 8 + (text[0] - 'a');
+    int to = ('8' - text[3]) * 8 + (text[2] - 'a');
+
+    for(const Move& move : Check::genAllSafeMoves(board, board.getCurrentTurn())) {
+        if(move.from() == from && move.to() == to) {
+            board.makeMove(move);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The material-only evaluator the search used before the incremental one: every leaf scans all 64 squares
+static int scanEvaluate(const Board& board) {
+    static const int values[6] = {100, 9, 5, 3, 3, 1};
+    int score = 0;
+    for(int i = 0; i < 8; i++) {
+        for(int j = 0; j < 8; j++) {
+            if(board[i][j] == EMPTY) continue;
+            int value = values[static_cast<int>(board[i][j]->getType())];
+            score += board[i][j]->getTeam() == board.getCurrentTurn() ? value : -value;
+        }
+    }
+    return score;
+}
+
+// Walks every leaf below the position with make and unmake, as the search does, and evaluates it. The sum of
+// the scores keeps the compiler from dropping the calls
+template<typename Evaluate>
+static uint64_t evaluateLeaves(Board& board, int depth, Evaluate evaluate, int64_t& scoreSum) {
+    if(depth == 0) {
+        scoreSum += evaluate(board);
+        return 1;
+    }
+    uint64_t leaves = 0;
+    for(const Move& move : Check::genAllSafeMoves(board, board.getCurrentTurn())) {
+        board.makeMove(move);
+        leaves += evaluateLeaves(board, depth - 1, evaluate, scoreSum);
+        board.unmakeMove();
+    }
+    return leaves;
+}
+
+template<typename Evaluate>
+static double leavesPerSecond(const std::vector<Board>& boards, int depth, Evaluate evaluate) {
+    uint64_t leaves = 0;
+    int64_t scoreSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(Board board : boards) leaves += evaluateLeaves(board, depth, evaluate, scoreSum);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(scoreSum == 1) std::cout << std::endl;
+    return leaves / seconds;
+}
+
+// The piece dispatch used before the jump table: a hash lookup, then a type-erased call
+static const std::unordered_map<Type, std::function<bool(const Board&, Position, Position)>> mapDispatch = {
+    {Type::KING, checkUtils::canMoveKing},
+    {Type::QUEEN, checkUtils::canMoveQueen},
+    {Type::ROOK, checkUtils::canMoveRook},
+    {Type::KNIGHT, checkUtils::canMoveKnight},
+    {Type::BISHOP, checkUtils::canMoveBishop},
+    {Type::PAWN, checkUtils::canMovePawn}};
+
+// Checks every piece on the positions against every target square over and over and returns the time per call in
+// nanoseconds. The count of accepted moves keeps the compiler from dropping the calls
+template<typename CanMove>
+static double nanosecondsPerCall(const std::vector<Board>& boards, int rounds, CanMove canMove) {
+    uint64_t calls = 0, accepted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++) {
+        for(const Board& board : boards) {
+            for(int square = 0; square < 64; square++) {
+                Position pos = Board::toPosition(square);
+                if(board[pos.rank][pos.file] == EMPTY) continue;
+                for(int target = 0; target < 64; target++) {
+                    accepted += canMove(board, pos, Board::toPosition(target));
+                    calls++;
+                }
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(accepted == 1) std::cout << std::endl;
+    return seconds * 1e9 / calls;
+}
+
+// Usage: bench [maxThreads] [depth]
+// Searches every position to a fixed depth with 1, 2, 4, ... threads and reports time-to-depth speedup
+// Usage: bench eval [depth]
+// Evaluates every leaf below the positions with the old full-scan evaluator and the incremental one
+// Usage: bench dispatch [rounds]
+// Times a per-piece move check dispatched through the old hash map and through the jump table
+int main(int argc, char* argv[]) {
+    bool evalBench = argc > 1 && std::string(argv[1]) == "eval";
+    bool dispatchBench = argc > 1 && std::string(argv[1]) == "dispatch";
+    int maxThreads = argc > 1 && !evalBench && !dispatchBench ? std::atoi(argv[1]) :
+                                                                static_cast<int>(std::thread::hardware_concurrency());
+    int depth = argc > 2 ? std::atoi(argv[2]) : (evalBench ? 4 : 5);
+    if(maxThreads < 1) maxThreads = 1;
+
+    std::vector<Board> boards;
+    for(const char* line : benchPositions) {
+        Board board(Team::WHITE);
+        std::istringstream moves(line);
+        std::string move;
+        while(moves >> move) {
+            if(!playMove(board, move)) {
+                std::cerr << "Illegal benchmark move " << move << std::endl;
+                return 1;
+            }
+        }
+        boards.push_back(board);
+    }
+
+    if(evalBench) {
+        double scanRate = leavesPerSecond(boards, depth, scanEvaluate);
+        double incrementalRate = leavesPerSecond(boards, depth, [](const Board& board) {return AI::evaluateBoard(board);});
+        std::cout << "full scan:   " << static_cast<uint64_t>(scanRate) << " leaves/s" << std::endl;
+        std::cout << "incremental: " << static_cast<uint64_t>(incrementalRate) << " leaves/s, " << std::fixed
+                  << std::setprecision(2) << incrementalRate / scanRate << "x" << std::endl;
+        return 0;
+    }
+
+    if(dispatchBench) {
+        int rounds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5000;
+        double mapTime = nanosecondsPerCall(boards, rounds, [](const Board& board, Position startPos, Position endPos) {
+            return mapDispatch.at(board[startPos.rank][startPos.file]->getType())(board, startPos, endPos);
+        });
+        double tableTime = nanosecondsPerCall(boards, rounds, checkUtils::canMove);
+        std::cout << "hash map:    " << std::fixed << std::setprecision(1) << mapTime << " ns/call" << std::endl;
+        std::cout << "jump table:  " << tableTime << " ns/call, " << std::setprecision(2) << mapTime / tableTime << "x"
+                  << std::endl;
+        return 0;
+    }
+
+    std::vector<int> threadCounts;
+    for(int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    double baseTime = 0;
+    for(int threads : threadCounts) {
+        AI::setThreads(threads);
+        uint64_t nodes = 0;
+        double cutoffRate = 0;
+        uint64_t pawnHits = 0, pawnProbes = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for(const Board& board : boards) {
+            AI::clearHash();
+            AI::genAIMove(board, depth, board.getCurrentTurn());
+            nodes += AI::getNodeCount();
+            cutoffRate += AI::getFirstMoveCutoffRate() / boards.size();
+            pawnHits += AI::getPawnHashStats().hits;
+            pawnProbes += AI::getPawnHashStats().hits + AI::getPawnHashStats().misses;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(threads == 1) baseTime = seconds;
+        std::cout << std::setw(3) << threads << " threads: " << std::fixed << std::setprecision(3) << seconds << " s, "
+                  << nodes << " nodes, " << static_cast<uint64_t>(nodes / seconds) << " nps, speedup "
+                  << std::setprecision(2) << baseTime / seconds << "x, first-move cutoffs " << std::setprecision(1)
+                  << cutoffRate * 100 << "%, pawn hash hits " << 100.0 * pawnHits / std::max<uint64_t>(pawnProbes, 1) << "%"
+                  << std::endl;
+    }
+    return 0;
+}
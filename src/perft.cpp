@@ -0,0 +1,150 @@
+#include "Board.hpp"
+#include "Check.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+static const char* startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// Published node counts for the standard perft positions
+static const PerftCase perftSuite[] = {
+    {"start", startFen, 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+};
+
+// Counts the leaf nodes below the position. The last ply is counted from the move list without being played
+static uint64_t perft(Board& board, int depth) {
+    MoveList moves = Check::genAllSafeMoves(board, board.getCurrentTurn());
+    if(depth == 1) return moves.size();
+
+    uint64_t nodes = 0;
+    for(const Move& move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove();
+    }
+    return nodes;
+}
+
+// Counts the subtree of every root move. Threads take root moves from a shared counter, each on its own board
+static std::vector<uint64_t> perftRoot(const Board& board, const MoveList& moves, int depth, int threadCount) {
+    std::vector<uint64_t> counts(moves.size());
+    std::atomic<size_t> nextMove(0);
+
+    auto worker = [&]() {
+        Board threadBoard(board);
+        for(size_t i = nextMove++; i < moves.size(); i = nextMove++) {
+            threadBoard.makeMove(moves[i]);
+            counts[i] = depth > 1 ? perft(threadBoard, depth - 1) : 1;
+            threadBoard.unmakeMove();
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for(int i = 1; i < threadCount; i++) helpers.emplace_back(worker);
+    worker();
+    for(std::thread& helper : helpers) helper.join();
+    return counts;
+}
+
+// Moves are printed in coordinate notation, e.g. "e2e4", with the promotion piece appended ("e7e8n")
+static std::string squareName(int square) {
+    return std::string{static_cast<char>('a' + square % 8), static_cast<char>('8' - square / 8)};
+}
+
+static std::string moveName(const Move& move) {
+    static const char promotionLetters[] = "kqrnbp";
+    std::string name = squareName(move.from()) + squareName(move.to());
+    if(move.isPromotion()) name += promotionLetters[static_cast<int>(move.promotionType())];
+    return name;
+}
+
+// Runs one position and prints the node count with its speed. Divide also lists the count below each root move
+static uint64_t runPerft(const Board& board, int depth, int threadCount, bool divide) {
+    auto startTime = std::chrono::steady_clock::now();
+    MoveList moves = Check::genAllSafeMoves(board, board.getCurrentTurn());
+    std::vector<uint64_t> counts = perftRoot(board, moves, depth, threadCount);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    uint64_t nodes = 0;
+    for(size_t i = 0; i < moves.size(); i++) {
+        if(divide) std::cout << moveName(moves[i]) << ": " << counts[i] << std::endl;
+        nodes += counts[i];
+    }
+    if(divide) std::cout << std::endl;
+
+    std::cout << "depth " << depth << ": " << nodes << " nodes, " << std::fixed << std::setprecision(3) << seconds << " s, "
+              << static_cast<uint64_t>(nodes / std::max(seconds, 1e-9)) << " nps" << std::endl;
+    return nodes;
+}
+
+// Usage: perft [-t threads] [divide] [depth [fen]]
+// Without a depth the standard suite is run, and the exit code reports whether every count matched
+int main(int argc, char* argv[]) {
+    int threadCount = 1;
+    bool divide = false;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "-t" && i + 1 < argc) {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        } else if(arg == "divide") {
+            divide = true;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if(args.empty()) {
+        int failures = 0;
+        for(const PerftCase& test : perftSuite) {
+            Board board(Team::WHITE);
+            board.loadFen(test.fen);
+            std::cout << test.name << ", ";
+            uint64_t nodes = runPerft(board, test.depth, threadCount, divide);
+            if(nodes != test.nodes) {
+                std::cout << "  MISMATCH: expected " << test.nodes << std::endl;
+                failures++;
+            }
+        }
+        std::cout << (failures == 0 ? "All positions match" : std::to_string(failures) + " position(s) failed") << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    int depth = std::atoi(args[0].c_str());
+    if(depth < 1) {
+        std::cerr << "Depth must be at least 1" << std::endl;
+        return 1;
+    }
+
+    // The FEN may be passed as one quoted argument or as its separate fields
+    std::string fen;
+    for(size_t i = 1; i < args.size(); i++) fen += (i > 1 ? " " : "") + args[i];
+    if(fen.empty()) fen = startFen;
+
+    Board board(Team::WHITE);
+    if(!board.loadFen(fen)) {
+        std::cerr << "Invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+    runPerft(board, depth, threadCount, divide);
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "AI.hpp"
+#include "Board.hpp"
+#include "Check.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+static const char* startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// The search thread reports while the main thread keeps answering commands, so every line goes through here
+static std::mutex outputMutex;
+static void send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+// UCI forbids sending bestmove during an infinite or pondering search until the GUI sends stop or ponderhit
+static std::mutex holdMutex;
+static std::condition_variable holdReleased;
+static bool holdBestMove = false;
+static bool infiniteSearch = false;
+
+static void releaseBestMove() {
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        holdBestMove = false;
+    }
+    holdReleased.notify_all();
+}
+
+// Moves use coordinate notation such as "e2e4", with the promotion piece appended ("e7e8q")
+static std::string squareName(int square) {
+    return std::string{static_cast<char>('a' + square % 8), static_cast<char>('8' - square / 8)};
+}
+
+static std::string moveName(const Move& move) {
+    static const char promotionLetters[] = "kqrnbp";
+    std::string name = squareName(move.from()) + squareName(move.to());
+    if(move.isPromotion()) name += promotionLetters[static_cast<int>(move.promotionType())];
+    return name;
+}
+
+static Move parseMove(const Board& board, const std::string& text) {
+    if(text.size() < 4) return INVALID_MOVE;
+    for(const Move& move : Check::genAllSafeMoves(board, board.getCurrentTurn())) {
+        if(moveName(move) == text) return move;
+    }
+    return INVALID_MOVE;
+}
+
+// position [startpos | fen <fen>] [moves <move> ...]
+static void setPosition(Board& board, std::istringstream& input) {
+    std::string token, fen;
+    input >> token;
+    if(token == "startpos") {
+        fen = startFen;
+        input >> token;
+    } else if(token == "fen") {
+        while(input >> token && token != "moves") fen += token + " ";
+    } else {
+        return;
+    }
+
+    Board position(Team::WHITE);
+    if(!position.loadFen(fen)) {
+        send("info string invalid fen " + fen);
+        return;
+    }
+    if(token == "moves") {
+        while(input >> token) {
+            Move move = parseMove(position, token);
+            if(move == INVALID_MOVE) {
+                send("info string illegal move " + token);
+                break;
+            }
+            position.playMove(move);
+        }
+    }
+    board = position;
+}
+
+// Mate scores are reported in moves, everything else in centipawns
+static std::string scoreText(int score) {
+    if(score >= AI::MATE_THRESHOLD) return "mate " + std::to_string((AI::MATE_SCORE - score + 1) / 2);
+    if(score <= -AI::MATE_THRESHOLD) return "mate -" + std::to_string((AI::MATE_SCORE + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+// Only known when the engine was built with CHESS_SEARCH_STATS
+static std::string seldepthText() {
+    int selectiveDepth = AI::getSearchStats().maxSelectiveDepth;
+    return selectiveDepth > 0 ? " seldepth " + std::to_string(selectiveDepth) : "";
+}
+
+// go [depth n] [movetime ms] [wtime ms] [btime ms] [winc ms] [binc ms] [movestogo n] [nodes n] [infinite] [ponder]
+static void startSearch(const Board& board, std::istringstream& input) {
+    AI::SearchLimits limits;
+    int moveTime = 0, movesToGo = 0;
+    int clockTime[2] = {0, 0}, increment[2] = {0, 0};
+    bool infinite = false;
+
+    std::string token;
+    while(input >> token) {
+        if(token == "depth") {
+            // Deeper requests would overflow the ply-indexed tables and the board's move history
+            input >> limits.maxDepth;
+            limits.maxDepth = std::max(1, std::min(limits.maxDepth, AI::MAX_DEPTH));
+        }
+        else if(token == "movetime") input >> moveTime;
+        else if(token == "wtime") input >> clockTime[0];
+        else if(token == "btime") input >> clockTime[1];
+        else if(token == "winc") input >> increment[0];
+        else if(token == "binc") input >> increment[1];
+        else if(token == "movestogo") input >> movesToGo;
+        else if(token == "nodes") input >> limits.maxNodes;
+        else if(token == "infinite") infinite = true;
+        else if(token == "ponder") limits.ponder = true;
+    }
+
+    // With a clock, spend an even share of the remaining time plus most of the increment, keeping a margin for lag
+    int team = static_cast<int>(board.getCurrentTurn());
+    if(moveTime > 0) {
+        limits.timeMs = moveTime;
+    } else if(clockTime[team] > 0) {
+        int share = clockTime[team] / (movesToGo > 0 ? movesToGo : 30) + increment[team] * 3 / 4;
+        limits.timeMs = std::max(1, std::min(share, clockTime[team] - 50));
+    }
+    if(infinite) limits.timeMs = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        holdBestMove = infinite || limits.ponder;
+        infiniteSearch = infinite;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    AI::startSearch(board, limits, board.getCurrentTurn(), [board, startTime](Move bestMove) {
+        {
+            std::unique_lock<std::mutex> lock(holdMutex);
+            holdReleased.wait(lock, []() {return !holdBestMove;});
+        }
+        if(bestMove == INVALID_MOVE) {
+            send("bestmove 0000");
+            return;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+        uint64_t nodes = AI::getNodeCount();
+        send("info depth " + std::to_string(AI::getDepth()) + seldepthText() + " score " + scoreText(AI::getScore()) +
+             " nodes " + std::to_string(nodes) + " time " + std::to_string(elapsed) +
+             " nps " + std::to_string(nodes * 1000 / std::max<int64_t>(elapsed, 1)) + " pv " + moveName(bestMove));
+
+        // The reply stored in the table is the move to ponder on
+        Board next(board);
+        next.playMove(bestMove);
+        Move ponderMove = AI::getHashMove(next);
+        send("bestmove " + moveName(bestMove) + (ponderMove == INVALID_MOVE ? "" : " ponder " + moveName(ponderMove)));
+    });
+}
+
+static void stopSearch() {
+    releaseBestMove();
+    AI::stopSearch();
+    AI::waitForSearch();
+}
+
+// Commands that replace the position let a running search finish first, so scripted input can be piped in
+// without waiting for each bestmove. An infinite or pondering search would never finish, so it is stopped
+static void finishSearch() {
+    bool held;
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        held = holdBestMove;
+    }
+    if(held) stopSearch();
+    else AI::waitForSearch();
+}
+
+// Usage: chess-uci, then UCI commands on standard input
+int main() {
+    Board board(Team::WHITE);
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        std::istringstream input(line);
+        std::string command;
+        input >> command;
+
+        if(command == "uci") {
+            send("id name EECS 22L Chess");
+            send("id author EECS 22L Chess developers");
+            send("option name Hash type spin default 16 min 1 max 4096");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("option name Ponder type check default false");
+            send("uciok");
+        } else if(command == "isready") {
+            send("readyok");
+        } else if(command == "setoption") {
+            // setoption name <id> value <x>
+            std::string token, name, value;
+            input >> token >> name >> token >> value;
+            // The transposition table and the thread count must not change under a running search
+            if(name == "Hash" || name == "Threads") finishSearch();
+            if(name == "Hash") AI::setHashSize(std::max(1, std::atoi(value.c_str())));
+            else if(name == "Threads") AI::setThreads(std::atoi(value.c_str()));
+        } else if(command == "ucinewgame") {
+            finishSearch();
+            AI::clearHash();
+        } else if(command == "position") {
+            finishSearch();
+            setPosition(board, input);
+        } else if(command == "go") {
+            finishSearch();
+            startSearch(board, input);
+        } else if(command == "d") {
+            // Not part of UCI: reports the current position, e.g. to replay it later with position fen
+            send("info string fen " + board.toFen());
+        } else if(command == "stop") {
+            stopSearch();
+        } else if(command == "ponderhit") {
+            // The search carries on with its time limit now running; an infinite one still waits for stop
+            AI::ponderHit();
+            bool release;
+            {
+                std::lock_guard<std::mutex> lock(holdMutex);
+                release = !infiniteSearch;
+            }
+            if(release) releaseBestMove();
+        } else if(command == "quit") {
+            stopSearch();
+            return 0;
+        }
+    }
+
+    // End of input lets the last search finish, so piped commands still get their bestmove
+    finishSearch();
+    return 0;
+}